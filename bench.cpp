@@ -0,0 +1,388 @@
+// Benchmarks for the Frame Machine of Frame Toy
+
+// Measures hot paths of the toy: inner dispatch per class of atoms, composites, tokenizer, numerals,
+// dictionary lookup and end-to-end interpretation of synthetic scripts of various sizes and mixes of symbols.
+// The toy is embedded whole, so benchmarks see exactly what ft executes.
+// Results are JSON lines on standard output, one per case: ns per operation and operations (atoms) per second.
+// With "check", differential checks run instead: fast execution paths against the reference one on random programs.
+// Usage: ftbench [milliseconds per case] | ftbench check
+
+#define FT_EMBEDDED
+#include "ft.cpp"
+
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <csetjmp>
+#include <csignal>
+
+// keep compiler from optimizing measured work away
+template<typename T> inline void keep (T const& value) { asm volatile ("" : : "g" (&value) : "memory"); }
+
+std::chrono::nanoseconds budget = std::chrono::milliseconds (100);
+
+// run a body repeatedly, doubling repetitions until budget is spent. body returns how many operations it did
+template<typename BODY> void measure (std::string_view const bench, std::string_view const name, BODY body) {
+  using clock = std::chrono::steady_clock;
+  std::size_t repetitions = 1, operations = 0;
+  clock::duration elapsed {};
+
+  for (;;) {
+    operations = 0;
+    auto const start = clock::now();
+    for (std::size_t i = 0; i < repetitions; ++i)
+      operations += body();
+    elapsed = clock::now() - start;
+    if (elapsed >= budget || repetitions >= (std::size_t (1) << 40)) break;
+    repetitions *= 2;
+  }
+  double const ns = std::chrono::duration<double, std::nano> (elapsed).count();
+  std::cout << "{\"bench\":\"" << bench << "\",\"case\":\"" << name << "\",\"ops\":" << operations
+            << ",\"ns_per_op\":" << ns / operations << ",\"ops_per_sec\":" << operations * 1e9 / ns << "}\n";
+}
+
+// frames of benchmarks keep their output to themselves, it is thrown away
+void quiet (FRAME& frame) { frame.output.sink = -1; }
+
+// inner dispatch. each case is a short balanced sequence of atoms, so the stack does not drift
+void bench_primitives (void) {
+  const std::pair<std::string_view, std::vector<Atom> > cases [] { // vectors, initializer lists would dangle here
+    { "constant", { ONE, DROP } },
+    { "stack",    { DUP, SWAP, OVER, DROP, DROP } },
+    { "arith",    { ONE, PLUS, TWO, MULT, TWO, DIV, ONE, MINUS } },
+    { "flag",     { FLAG_SET, FLAG_QUERY, FLAG_STORE, FLAG_RESET } },
+    { "base",     { HEX, DEC, OCT, DEC } },
+    { "output",   { DUP, DOT } },
+    { "super",    { DUP_DUP, SWAP_DROP, DROP } },
+  };
+  for (auto const& [name, atoms] : cases) {
+    FRAME frame; quiet (frame);
+    frame.data_stack.push (7);
+    measure ("execute_primitive", name, [&] {
+      for (auto const atom : atoms)
+        execute_primitive (frame, atom);
+      frame.output.pending().clear();
+      return atoms.size();
+    });
+  }
+}
+
+void bench_composites (void) {
+  FRAME frame; quiet (frame);
+  frame.data_stack.push (7);
+  measure ("execute_composite", "2dup 2drop", [&] {
+    execute_composite (frame, _2DUP), execute_composite (frame, _2DROP);
+    return std::size_t (2);
+  });
+  frame.data_stack.push (7);
+  measure ("execute_composite", "2over 2drop", [&] {
+    execute_composite (frame, _2OVER), execute_composite (frame, _2DROP);
+    return std::size_t (2);
+  });
+  measure ("composite", "2dup 2drop", [&] { // compile-time composites, direct calls
+    definition_composite_2DUP::primitive (frame), definition_composite_2DROP::primitive (frame);
+    return std::size_t (2);
+  });
+  measure ("composite", "2over 2drop", [&] {
+    definition_composite_2OVER::primitive (frame), definition_composite_2DROP::primitive (frame);
+    return std::size_t (2);
+  });
+  interpret (frame, tokenize (": 2dup-2drop 2dup 2drop ;")); // same as a word, its body in frame's arena
+  auto const word = frame.words.find ("2dup-2drop");
+  measure ("execute_word", "2dup 2drop", [&] {
+    execute_primitive (frame, word);
+    return std::size_t (1);
+  });
+}
+
+// synthetic scripts. symbols are picked by mix, following stack depth so the script stays balanced and never underflows
+struct MIX { std::string_view name; int numerals, constants, arithmetic, stack; };
+
+constexpr MIX mixes [] {
+  { "numerals", 6, 0, 3, 1 },
+  { "arith",    2, 2, 5, 1 },
+  { "stack",    1, 3, 1, 5 },
+  { "mixed",    3, 2, 3, 2 },
+};
+
+std::string script (MIX const& mix, std::size_t const symbols, unsigned const seed) {
+  static constexpr std::string_view constants [] { "zero", "one", "two", "three", "0", "1", "2", "3" };
+  static constexpr std::string_view arithmetic [] { "+", "-", "*", "plus", "minus", "mult" }; // no division by zero surprises
+  static constexpr std::string_view stack [] { "dup", "swap", "over", "2dup" };
+  std::mt19937 random (seed);
+  std::string text; std::size_t depth = 0;
+
+  auto const emit = [&text] (std::string_view const symbol) { text.append (symbol), text.push_back (' '); };
+  for (std::size_t i = 0; i < symbols; ++i) {
+    int const total = mix.numerals + mix.constants + mix.arithmetic + mix.stack;
+    int pick = random() % total;
+    if (depth < 2) pick = mix.constants && random() % 2 ? mix.numerals : 0; // something to operate on, numeral or constant
+    else if (depth > 32) pick = mix.numerals + mix.constants; // enough of that, reduce
+    if (pick < mix.numerals) emit (std::to_string (10 + random() % 90000)), ++depth;
+    else if ((pick -= mix.numerals) < mix.constants) emit (constants [random() % std::size (constants)]), ++depth;
+    else if ((pick -= mix.constants) < mix.arithmetic) emit (arithmetic [random() % std::size (arithmetic)]), --depth;
+    else {
+      auto const symbol = stack [random() % std::size (stack)];
+      emit (symbol);
+      depth += symbol == "dup" || symbol == "over" ? 1 : symbol == "2dup" ? 2 : 0;
+    }
+  }
+  for (; depth; --depth) emit ("drop");
+  return text;
+}
+
+std::size_t count_tokens (std::string_view const text) {
+  std::size_t n = 0;
+  for (auto const token : tokenize (text)) keep (token), ++n;
+  return n;
+}
+
+void bench_tokenizer (void) {
+  for (std::size_t const size : { 16, 256, 4096 }) {
+    auto const text = script (mixes [3], size, 1);
+    measure ("tokenize", "mixed/" + std::to_string (size), [&] { return count_tokens (text); });
+  }
+}
+
+void bench_numerals (void) {
+  FRAME frame;
+  constexpr std::string_view numerals [] { "7", "42", "65535", "1234567", "21474836", "100", "9", "31337" }; // both bases
+  for (int const base : { 10, 16 }) {
+    frame.base = base;
+    measure ("as_numeral", base == 10 ? "dec" : "hex", [&] {
+      for (auto const numeral : numerals)
+        if (as_numeral (frame, numeral)) frame.data_stack.pop();
+      return std::size (numerals);
+    });
+  }
+}
+
+void bench_dictionary (void) {
+  constexpr std::string_view hits [] { "dup", "+", "swap", "three", "hello", "2over", "query?", "symbols" };
+  constexpr std::string_view misses [] { "dupe", "++", "swapped", "four", "42", "quux", "query", "symbol" };
+  measure ("outer_dictionary", "hit", [&] {
+    for (auto const symbol : hits) keep (outer_dictionary.find (symbol));
+    return std::size (hits);
+  });
+  measure ("outer_dictionary", "miss", [&] {
+    for (auto const symbol : misses) keep (outer_dictionary.find (symbol));
+    return std::size (misses);
+  });
+}
+
+// end-to-end. interpret resolves symbols every time, interpret_line goes through the program cache
+void bench_interpret (void) {
+  for (auto const& mix : mixes)
+    for (std::size_t const size : { 16, 256, 4096 }) {
+      auto const text = script (mix, size, size);
+      auto const atoms = count_tokens (text);
+      auto const name = std::string (mix.name) + "/" + std::to_string (size);
+      FRAME frame; quiet (frame);
+      measure ("interpret", name, [&] { interpret (frame, tokenize (text)); return atoms; });
+      measure ("interpret_line", name, [&] { interpret_line (frame, text); return atoms; });
+    }
+}
+
+// proven programs run unchecked. same program, with guards per atom and without any
+void bench_proofs (void) {
+  std::string const line = "dup dup * swap 3 * + 7 - dup 2 / swap drop 1 +"; // balanced, one cell in, one out
+  auto const program = compile (tokenize (line), 10);
+  auto const atoms = count_tokens (line);
+  FRAME frame; quiet (frame);
+  frame.data_stack.push (7);
+  measure ("execute_program", "checked", [&] {
+    execute_code (frame, program.code, program.unresolved), frame.data_stack.top() = 7;
+    return atoms;
+  });
+  measure ("execute_program", "proven", [&] {
+    execute_program (frame, program), frame.data_stack.top() = 7;
+    return atoms;
+  });
+}
+
+// snapshots of a frame with a deep stack and a hundred words. restore includes mapping and paging the file in
+void bench_snapshots (void) {
+  FRAME frame; quiet (frame);
+  for (int i = 0; i < 200; ++i) frame.data_stack.push (i);
+  for (int i = 0; i < 100; ++i) interpret (frame, tokenize (": word" + std::to_string (i) + " dup * " + std::to_string (i) + " + swap 2dup drop ;"));
+  std::string const path = "ftbench.snapshot";
+  measure ("snapshot", "image", [&] { keep (snapshot_image (frame)); return std::size_t (1); });
+  snapshot (frame, path);
+  FRAME restored; quiet (restored);
+  measure ("snapshot", "restore", [&] { keep (restore (restored, path)); return std::size_t (1); });
+  unlink (path.c_str());
+}
+
+// differential corpus. random lines over an alphabet covering stack, arithmetic, output, base and flag atoms,
+// division included with literal, zero and stack supplied divisors and with INT_MIN / -1, each against a frame
+// with a few random cells. two execution paths must leave equal outcomes: stack, base, flag and output,
+// or the same signal. division traps, so runs are guarded by a handler jumping back out of the trap
+struct CASE { std::string line; PROGRAM program; FRAME frame; };
+
+template<typename ACCEPT> std::vector<CASE> corpus (std::size_t const n, ACCEPT accept) {
+  static constexpr std::string_view alphabet [] {
+    "dup", "drop", "swap", "over", "+", "-", "*", "2dup", "2drop", "2over", "kilo", "depth?", ".",
+    "query?", "store!", "set", "reset", "hex", "dec", "oct", "0", "1", "2", "3", "10", "255", "-7", "2147483647",
+    "7 /", "-3 /", "0 /", "/", "-2147483648 -1 /"
+  };
+  std::mt19937 random (16);
+  std::vector<CASE> cases;
+  for (std::size_t i = 0; i < n; ++i) {
+    CASE c;
+    for (auto symbols = random() % 24; symbols--; )
+      c.line.append (alphabet [random() % std::size (alphabet)]).push_back (' ');
+    c.program = compile (tokenize (c.line), 10);
+    quiet (c.frame);
+    for (auto depth = random() % 6; depth--; ) c.frame.data_stack.push (int (random() % 8 == 0 ? random() % 3 : random()));
+    if (accept (c)) cases.push_back (std::move (c));
+  }
+  return cases;
+}
+
+std::string state_of (FRAME& frame) {
+  std::string s;
+  for (std::size_t i = frame.data_stack.size(); i--; ) s.append (std::to_string (frame.data_stack [i])).push_back (' ');
+  s.append ("base ").append (std::to_string (frame.base)).append (frame._FLAG() ? " set" : " reset");
+  return s.append (" output ").append (frame.output.pending());
+}
+
+sigjmp_buf trapped;
+void on_trap (int const signal) { siglongjmp (trapped, signal); }
+
+// frame of a trapped run is left half done, it is a copy thrown away
+template<typename RUN> std::string outcome (FRAME frame, RUN run) {
+  static bool const guarded = [] {
+    struct sigaction action {};
+    action.sa_handler = on_trap, action.sa_flags = SA_NODEFER;
+    return sigaction (SIGFPE, &action, nullptr) == 0;
+  } ();
+  if (int const signal = guarded ? sigsetjmp (trapped, 1) : 0) return "signal " + std::to_string (signal);
+  run (frame);
+  return state_of (frame);
+}
+
+// report a differential check as a JSON line. mismatching lines go to stderr
+bool report_check (std::string_view const name, std::size_t const programs, std::size_t const mismatches) {
+  std::cout << "{\"check\":\"" << name << "\",\"programs\":" << programs << ",\"mismatches\":" << mismatches << "}\n";
+  return mismatches == 0;
+}
+
+// unchecked execution of proven programs against checked execution of the same code
+bool check_unchecked (void) {
+  auto cases = corpus (20000, [] (CASE& c) { return c.program.proof.holds (c.frame.data_stack.size(), c.frame.data_stack.limit()); });
+  std::size_t mismatches = 0;
+  for (auto& c : cases) {
+    auto const code = std::span<const int> (c.program.code);
+    auto const checked = outcome (c.frame, [&] (FRAME& f) { execute_code (f, code); });
+    auto const unchecked = outcome (c.frame, [&] (FRAME& f) { execute_unchecked (f, code); });
+    if (checked != unchecked) std::cerr << "unchecked mismatch: " << c.line << '\n', ++mismatches;
+  }
+  return report_check ("unchecked", cases.size(), mismatches);
+}
+
+// compile-time composites, direct calls, against the same composites executed from their vocabulary
+bool check_composites (void) {
+  typedef void (*STATIC) (class FRAME&);
+  constexpr std::pair<Atom, STATIC> composites [] {
+    { _2DUP, definition_composite_2DUP::primitive }, { _2DROP, definition_composite_2DROP::primitive },
+    { _2OVER, definition_composite_2OVER::primitive }, { _3HELLO, definition_composite_3HELLO::primitive },
+    { KILO, definition_composite_KILO::primitive },
+  };
+  std::mt19937 random (15);
+  std::size_t programs = 0, mismatches = 0;
+  for (std::size_t n = 0; n < 1000; ++n) {
+    FRAME frame; quiet (frame);
+    for (auto depth = 4 + random() % 4; depth--; ) frame.data_stack.push (int (random()));
+    for (auto const& [atom, direct] : composites) {
+      if (outcome (frame, [&] (FRAME& f) { direct (f); }) != outcome (frame, [&] (FRAME& f) { execute_composite (f, atom); }))
+        std::cerr << "composite mismatch: " << int (atom) << '\n', ++mismatches;
+      ++programs;
+    }
+  }
+  return report_check ("composites", programs, mismatches);
+}
+
+// jit tier. random proven programs run interpreted and native against equal frames, must leave equal outcomes
+#ifdef FT_JIT
+bool check_jit (void) {
+  auto cases = corpus (5000, [] (CASE& c) { return c.program.proof.holds (c.frame.data_stack.size(), c.frame.data_stack.limit()); });
+  std::size_t mismatches = 0;
+  for (auto& c : cases) {
+    c.program.native = jit_compile (c.program);
+    if (! c.program.native) { std::cerr << "jit failed: " << c.line << '\n'; ++mismatches; continue; }
+    auto const interpreted = outcome (c.frame, [&] (FRAME& f) { execute_unchecked (f, c.program.code); });
+    auto const native = outcome (c.frame, [&] (FRAME& f) { execute_program (f, c.program); });
+    if (interpreted != native) std::cerr << "jit mismatch: " << c.line << '\n', ++mismatches;
+  }
+  return report_check ("jit", cases.size(), mismatches);
+}
+
+// speed of a promoted program against unchecked interpretation
+void bench_jit (void) {
+  std::string const line = "dup dup * swap 3 * + 7 - dup 2 / swap drop 1 +"; // balanced, one cell in, one out
+  auto program = compile (tokenize (line), 10);
+  auto const atoms = count_tokens (line);
+  FRAME frame; quiet (frame);
+  frame.data_stack.push (7);
+  measure ("jit", "unchecked", [&] {
+    execute_unchecked (frame, program.code), frame.data_stack.top() = 7;
+    return atoms;
+  });
+  program.native = jit_compile (program);
+  measure ("jit", "native", [&] {
+    execute_program (frame, program), frame.data_stack.top() = 7;
+    return atoms;
+  });
+}
+#endif
+
+// bulk evaluation. one program over many frames, frame by frame and in lanes, loading and storing included
+void bench_lanes (void) {
+  constexpr std::size_t frames_count = 64;
+  std::string const line = "dup dup * swap 3 * + 7 - dup 2 / swap drop 1 +"; // balanced, one cell in, one out
+  auto const program = compile (tokenize (line), 10);
+  auto const atoms = count_tokens (line) * frames_count;
+  std::vector<FRAME> frames (frames_count);
+  for (std::size_t i = 0; i < frames_count; ++i) quiet (frames [i]), frames [i].data_stack.push (i);
+
+  measure ("lanes", "scalar/64", [&] {
+    for (auto& frame : frames) execute_program (frame, program), frame.data_stack.top() = 1;
+    return atoms;
+  });
+  auto lanes = std::make_unique<LANE_FRAME<frames_count> >();
+  measure ("lanes", "lanes/64", [&] {
+    lanes->load (frames), execute_lanes (*lanes, program), lanes->store (frames);
+    for (auto& frame : frames) frame.data_stack.top() = 1;
+    return atoms;
+  });
+  measure ("lanes", "resident/64", [&] { // frames stay in lanes between programs
+    execute_lanes (*lanes, program), lanes_fill (lanes->row (0), 1, frames_count);
+    return atoms;
+  });
+}
+
+int main (int argc, char* argv []) {
+  if (argc > 1 && std::string_view (argv [1]) == "check") {
+    bool passed = check_unchecked();
+    passed = check_composites() && passed;
+#ifdef FT_JIT
+    passed = check_jit() && passed;
+#endif
+    return passed ? 0 : 1;
+  }
+  if (argc > 1) budget = std::chrono::milliseconds (std::max (1, std::atoi (argv [1])));
+  std::cout.precision (4);
+
+  bench_primitives();
+  bench_composites();
+  bench_tokenizer();
+  bench_numerals();
+  bench_dictionary();
+  bench_interpret();
+  bench_proofs();
+  bench_lanes();
+  bench_snapshots();
+#ifdef FT_JIT
+  bench_jit();
+#endif
+}
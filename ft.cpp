@@ -8,15 +8,58 @@
 
 #include <iostream>
 #include <string>
-#include <sstream>
-#include <iomanip>
+#include <string_view>
 #include <utility>
+#include <iterator>
+#include <cstdint>
 #include <initializer_list>
+#include <functional>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <atomic>
+#include <chrono>
 
-#include <deque>
-#include <stack>  
 #include <map>
 #include <list>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <span>
+#include <memory>
+#include <bitset>
+#include <bit>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifdef __linux__
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#ifdef FT_JIT
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/TargetSelect.h>
+#endif
 
 // Frame.
 // Frame is a fundamental concept here
@@ -25,7 +68,8 @@
 //   - the language construction here is not part of the frame by design, to demonstrate ability to augment foreign c++ objects for scripting.
 //   - interpreter endorsing the frame has two layers: outer, which uses symbols and inner, which uses atoms
 //   - at first glance, symbolic language constructed in this demonstrator may look like Forth, but it is not.
-//     it is not structured. it has numerals but no literals. it has no flow control. it is not Turing-complete. it is not recursive.
+//     it is not structured. it has numerals, compiled into literal cells of programs, composites and words,
+//     but no literals of other kinds. it has no flow control. it is not Turing-complete. it is not recursive.
 //     it reflects C++ functions, by declarations. consider it rather imperative command language, like JCL or Unix shells. this is by design.
 //   - we call specific execution model represented by constructed interpreter a Frame Machine
 // Frame-related primitives may be global/external functions or functions templates, operating on frame or independently callable 
@@ -37,17 +81,135 @@
 // Generally we combine operators on frame and operators on structures embedded in frame into one symbolic language
 //    finally, a simple console is implemented for play with the frame. This makes whole contraption looking like an interpreter
 
-class FRAME {
+// data stack storage.
+// frame's data stack is a contiguous array of fixed capacity with a top of stack pointer. it stays cache resident,
+// never allocates and allows operators to work in place, on cells below the top.
+// it borrows push, pop, top, empty and size from std::stack, but frames need more of it: cells indexed from the top,
+// unchecked pushes, a raw pointer for native code, bound and limit, overflowed, drop, clear and pad_bottom.
+// a stack may be bounded below its capacity, for depth quota of a frame. overflow is not reported on the spot,
+// it is remembered for its owner to pick up, once per program
+template<typename T, std::size_t CAPACITY> class ARRAY_STACK {
+  T cells [CAPACITY];
+  T* sp = cells; // top of stack pointer, points just above the top cell
+  T* end = cells + CAPACITY; // pushing stops here
+
+public:
+  typedef T value_type;
+  static constexpr std::size_t capacity = CAPACITY;
+  bool overflowed = false; // some value was lost since it was last reset
+
+  ARRAY_STACK () = default;
+  ARRAY_STACK (const ARRAY_STACK& other) { *this = other; }
+  ARRAY_STACK& operator= (const ARRAY_STACK& other) { // pointers must not escape into the copied array
+    sp = std::copy (static_cast<const T*> (other.cells), static_cast<const T*> (other.sp), cells);
+    end = cells + other.limit(), overflowed = other.overflowed;
+    return *this;
+  }
+
+  bool empty (void) const { return sp == cells; }
+  std::size_t size (void) const { return sp - cells; }
+  bool full (void) const { return sp >= end; }
+  std::size_t limit (void) const { return end - cells; } // depth pushing stops at
+  void bound (std::size_t const depth) { end = cells + (depth ? std::min (depth, CAPACITY) : CAPACITY); } // zero unbounds
+
+  T& top (void) { return sp [-1]; }
+  const T& top (void) const { return sp [-1]; }
+  void pop (void) { --sp; }
+  void push (T const value) { // overflow costs one compare. overflowing value is lost
+    if (full()) [[unlikely]] {
+      overflowed = true;
+      return;
+    }
+    *sp++ = value;
+  }
+  void push_unchecked (T const value) { *sp++ = value; } // for callers having proven there is room
+  T*& pointer (void) { return sp; } // for native code working on cells itself. it keeps the pointer in the array
+
+  // in place access. depth 0 is the top cell. callers check depth themselves
+  T& operator[] (std::size_t const depth) { return sp [-1 - std::ptrdiff_t (depth)]; }
+  const T& operator[] (std::size_t const depth) const { return sp [-1 - std::ptrdiff_t (depth)]; }
+  void drop (std::size_t const n) { sp -= n; }
+  void clear (void) { sp = cells; }
+
+  // supply n zero cells under the bottom cell. this is a slow path for underflow recovery
+  void pad_bottom (std::size_t n) {
+    n = std::min (n, std::size_t (cells + CAPACITY - sp));
+    std::copy_backward (cells, sp, sp + n);
+    std::fill (cells, cells + n, T (0));
+    sp += n;
+  }
+};
+
+// output channel.
+// frame's output is gathered in a buffer and written to its sink in large pieces, when a threshold is reached
+// or when flushed explicitly. interactive host flushes per line, batch host practically never.
+// a quota bounds bytes produced since its host last refilled it. output over quota is dropped and counted.
+// copies start empty, output already produced belongs to the original
+class OUTPUT {
+  std::string buffer;
+
 public:
-  std::stack<int> data_stack; // forth-like RPN arithmetic data stack
-  // in c++ standard, std::stack is an adapter to std::deque, which is (by standard) already a tree, for adequate complexity.
-  // therefore, we recommend using deque for more advanced structured frames.
+  int sink = STDOUT_FILENO; // file descriptor. negative sink keeps everything buffered, for the host to collect
+  std::size_t threshold = 1 << 16;
+  std::size_t quota = 0, produced = 0; // bytes. zero quota is unlimited
+
+  OUTPUT () = default;
+  OUTPUT (const OUTPUT& other) : sink (other.sink), threshold (other.threshold), quota (other.quota) {}
+  OUTPUT& operator= (const OUTPUT& other) {
+    flush(), sink = other.sink, threshold = other.threshold, quota = other.quota;
+    return *this;
+  }
+  ~OUTPUT () { flush(); }
+
+  bool exceeded (void) const { return quota && produced > quota; }
+
+  OUTPUT& operator<< (std::string_view const s) {
+    produced += s.size();
+    if (exceeded()) [[unlikely]] return *this;
+    buffer.append (s);
+    if (buffer.size() >= threshold) [[unlikely]] flush();
+    return *this;
+  }
+  OUTPUT& operator<< (char const c) { return *this << std::string_view (&c, 1); }
+
+  // numbers are shown in base. like iostreams do, non decimal bases show the bits as unsigned
+  void number (int const n, int const base) {
+    char digits [40];
+    auto const r = base == 10 ? std::to_chars (digits, digits + sizeof digits, n)
+                              : std::to_chars (digits, digits + sizeof digits, unsigned (n), base);
+    *this << std::string_view (digits, r.ptr - digits);
+  }
+
+  void flush (void) {
+    if (sink < 0) return;
+    for (std::size_t done = 0; done < buffer.size(); ) {
+      auto const n = ::write (sink, buffer.data() + done, buffer.size() - done);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) break; // sink is gone, output is lost
+      done += n;
+    }
+    buffer.clear();
+  }
+
+  std::string& pending (void) { return buffer; } // for hosts collecting output themselves
+};
+
+constexpr std::size_t FRAME_STACK_CAPACITY = 256; // default data stack capacity, in cells
+
+// the frame template, parameterized on its data stack storage
+template<typename STACK> class BASIC_FRAME {
+public:
+  STACK data_stack; // forth-like RPN arithmetic data stack
+  // storage is ARRAY_STACK or anything with its whole interface, std::stack alone does not do.
+  // stack primitives of the toy work in place, on cells below the top
+
+  OUTPUT output; // frame's own output channel
 
   int base = 10; // numeric base setter. stores an integer. this is a kludge for ye olde compiler
   // std::ios_base& base (std::ios_base&) = std::ios_base::dec; // iomanip base setter. stores a value for ostream manipulator
 
 private:  
-  bool flag; // some fancy indicator which just demonstrates a hidden part of this frame, accessible by tokens only
+  bool flag = false; // some fancy indicator which just demonstrates a hidden part of this frame, accessible by tokens only
   // such kind of frame augmenting can be done to any c++ object, turning it into a scriptable machine
 
 public:  // expose indicator flag manipulators, as usual in getters/setters common pattern
@@ -55,22 +217,24 @@ public:  // expose indicator flag manipulators, as usual in getters/setters comm
   void _FLAG_RESET (void);
   void _FLAG_QUERY (void);
   void _FLAG_STORE (void);
+  bool _FLAG (void) const { return flag; } // for snapshots
   
-} frame; // let's have one
+};
 
 // implementations of exposed member functions
-void FRAME::_FLAG_SET (void) { flag = true; };
-void FRAME::_FLAG_RESET (void) { flag = false; };
-void FRAME::_FLAG_QUERY (void) { data_stack.push(flag); };
-void FRAME::_FLAG_STORE (void) {
+template<typename STACK> void BASIC_FRAME<STACK>::_FLAG_SET (void) { flag = true; };
+template<typename STACK> void BASIC_FRAME<STACK>::_FLAG_RESET (void) { flag = false; };
+template<typename STACK> void BASIC_FRAME<STACK>::_FLAG_QUERY (void) { data_stack.push(flag); };
+template<typename STACK> void BASIC_FRAME<STACK>::_FLAG_STORE (void) {
     if (data_stack.empty()) {    
-      std::cerr << "Warning: missing value, flag set operation ignored by frame" << std::endl;
+      std::cerr << "Warning: missing value, flag set operation ignored by frame\n";
       return;
     }
     flag = data_stack.top();
     data_stack.pop();
 };
 
+
 // atoms.
 // some naive atoms for defined primitives, applicable to that frame
 // atoms are acting radicals, represented as integers in all internal mechanics. may evolve into typed cells in far future
@@ -82,7 +246,8 @@ void FRAME::_FLAG_STORE (void) {
 
 // our atoms here are simple enum, because in this toy they are static. dynamic atoms creation (by jit compilers for example)
 // and frame composition shall require some better organized integers (like, atomspace arrays or intervals)
-typedef enum {
+// the enum has a fixed underlying type, so atoms past the built-in ones are valid values too, even in constant expressions
+typedef enum : int {
   // magical atom
   UNDEFINED = 0,
   // platform process control
@@ -97,12 +262,359 @@ typedef enum {
   DOT, DEC, HEX, OCT,
   // dictionary
   SYMBOLS,
+  // words defined at runtime: definitor and forgetting them all
+  DEFINE, FORGET,
   // technical demonstration, frame indicator manipulation
   FLAG_SET, FLAG_RESET, FLAG_QUERY, FLAG_STORE,
   // composites
-  _3HELLO,
+  _3HELLO, KILO,
+  // dictionary of fusions
+  FUSIONS,
+  // profiling
+  STATS, STATS_RESET,
+  // inner pseudo atoms. in compiled programs, they are followed by an inline operand cell
+  LITERAL, UNRESOLVED,
+  // superinstructions, fused by optimizer from frequent sequences. inner only, never exposed to symbols
+  DUP_DUP, OVER_OVER, SWAP_DROP,
+  PLUS_LITERAL, // followed by an inline operand cell too
+  // end of static atoms. not an atom itself, it marks where the built-in atomspace ends
+  STATIC_ATOMS
 } Atom;
 
+// atomspace is the dense range of integers atoms may occupy. built-in atoms fill its beginning,
+// the rest is reserved for atoms registered at runtime. its top interval is dynamic: words defined by frames.
+// every frame allocates word atoms from there on its own, so the same atom may be different words in different frames
+constexpr std::size_t ATOMSPACE = 256;
+constexpr std::size_t WORD_ATOMS = 128;
+constexpr Atom FIRST_WORD = Atom (ATOMSPACE - WORD_ATOMS);
+static_assert (STATIC_ATOMS <= FIRST_WORD, "atomspace too small for built-in atoms");
+constexpr std::size_t SUPERINSTRUCTIONS = PLUS_LITERAL - DUP_DUP + 1; // dense at the end of static atoms
+
+inline bool is_word (int const atom) { return atom >= FIRST_WORD && atom < int (ATOMSPACE); }
+
+// pseudo atoms and some superinstructions take an operand from the cell following them
+constexpr std::size_t operands_of (int const atom) {
+  return atom == LITERAL || atom == UNRESOLVED || atom == PLUS_LITERAL;
+}
+
+// stack effects.
+// language has no flow control and no recursion, so what code does to data stack depth is decidable before it runs.
+// every atom declares its effect: cells it takes and cells it gives, in Forth's ( in -- out ) sense.
+// atoms without a declaration have unknown effect, and so has any code executing them
+struct EFFECT { int in = -1, out = -1; }; // unknown by default
+
+constexpr std::pair<Atom, EFFECT> builtin_effects [] {
+  { UNDEFINED, { 0, 0 } },
+  { HELLO, { 0, 0 } }, { EXIT, { 1, 0 } }, { ABORT, { 0, 0 } }, { HELP, { 0, 0 } }, { QUIT, { 0, 0 } },
+  { ZERO,  { 0, 1 } }, { ONE,  { 0, 1 } }, { TWO,   { 0, 1 } }, { THREE, { 0, 1 } },
+  { DROP,  { 1, 0 } }, { DUP,  { 1, 2 } }, { SWAP,  { 2, 2 } }, { OVER,  { 2, 3 } }, { DEPTH, { 0, 1 } },
+  { PLUS,  { 2, 1 } }, { MINUS,{ 2, 1 } }, { MULT,  { 2, 1 } }, { DIV,   { 2, 1 } },
+  { DOT,   { 1, 0 } }, { DEC,  { 0, 0 } }, { HEX,   { 0, 0 } }, { OCT,   { 0, 0 } },
+  { SYMBOLS, { 0, 0 } }, { DEFINE, { 0, 0 } }, { FORGET, { 0, 0 } },
+  { FLAG_SET, { 0, 0 } }, { FLAG_RESET, { 0, 0 } }, { FLAG_QUERY, { 0, 1 } }, { FLAG_STORE, { 1, 0 } },
+  { FUSIONS, { 0, 0 } }, { STATS, { 0, 0 } }, { STATS_RESET, { 0, 0 } },
+  { LITERAL, { 0, 1 } }, // UNRESOLVED stays unknown, its warnings belong to checked execution
+  { DUP_DUP, { 1, 3 } }, { OVER_OVER, { 2, 4 } }, { SWAP_DROP, { 2, 1 } }, { PLUS_LITERAL, { 1, 1 } },
+  // composites are declared too. their flat bodies are verified against declarations when defined
+  { _2DUP, { 1, 3 } }, { _2DROP, { 2, 0 } }, { _2OVER, { 2, 4 } }, { _3HELLO, { 0, 0 } }, { KILO, { 1, 1 } },
+};
+
+// dense table indexed by atom, like vocabularies are. word atoms stay unknown, words are verified by their bodies
+constinit std::array<EFFECT, ATOMSPACE> effects = [] {
+  std::array<EFFECT, ATOMSPACE> effects {};
+  for (const auto& [atom, effect] : builtin_effects)
+    effects [atom] = effect;
+  return effects;
+} ();
+
+// verified effect of code. needs is the least depth code runs on without underflow, peak the most cells it holds
+// above its starting depth on the way, net the depth it leaves changed by. proof holds against a stack when
+// it has enough cells for needs and enough room for peak. then no operation of the code needs any guard
+struct PROOF {
+  bool known = false;
+  int needs = 0, net = 0, peak = 0;
+
+  bool holds (std::size_t const depth, std::size_t const capacity) const {
+    return known && depth >= std::size_t (needs) && depth + peak <= capacity;
+  }
+};
+
+// verifier walks flat code once, summing effects of its atoms
+inline PROOF verify (std::span<const int> const code) {
+  PROOF proof { true };
+  int depth = 0; // relative to the start
+  for (std::size_t i = 0; i < code.size(); i += 1 + operands_of (code [i])) {
+    auto const effect = effects [code [i]];
+    if (effect.in < 0) return PROOF();
+    proof.needs = std::max (proof.needs, effect.in - depth);
+    if (code [i] == PLUS_LITERAL) proof.peak = std::max (proof.peak, depth + 1); // its literal, pushed before PLUS
+    depth += effect.out - effect.in;
+    proof.peak = std::max (proof.peak, depth);
+  }
+  proof.net = depth;
+  return proof;
+}
+
+// atoms code executes, operand cells not counted. a superinstruction is one
+inline std::size_t instructions (std::span<const int> const code) {
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < code.size(); i += 1 + operands_of (code [i])) ++n;
+  return n;
+}
+
+// profiling.
+// optional instrumentation of inner execution: calls and nanoseconds per atom, undefined symbols and underflows met.
+// it is compiled in by FT_PROFILE only. otherwise frames carry an empty profile and all its hooks compile away.
+// nanoseconds are inclusive, a composite counts the time of atoms it executes
+#ifdef FT_PROFILE
+constexpr bool profiling = true;
+#else
+constexpr bool profiling = false;
+#endif
+
+struct PROFILE {
+  typedef std::chrono::steady_clock clock;
+
+  std::array<std::uint64_t, ATOMSPACE> calls {}, nanoseconds {};
+  std::uint64_t undefined = 0, underflows = 0;
+
+  static clock::time_point start (void) { return clock::now(); }
+  void record (int const atom, clock::time_point const since) {
+    ++calls [atom], nanoseconds [atom] += std::chrono::duration_cast<std::chrono::nanoseconds> (clock::now() - since).count();
+  }
+  void undefined_symbol (void) { ++undefined; }
+  void underflow (void) { ++underflows; }
+  void reset (void) { *this = PROFILE(); }
+};
+
+struct NO_PROFILE { // same hooks, doing nothing
+  struct STAMP {};
+
+  static STAMP start (void) { return {}; }
+  void record (int, STAMP) {}
+  void undefined_symbol (void) {}
+  void underflow (void) {}
+  void reset (void) {}
+};
+
+// arena.
+// bump allocator of cells in one contiguous block. allocations are offsets, not pointers, so they survive
+// growth of the block and copies of its owner. nothing is freed alone, everything is released at once by reset
+class ARENA {
+  std::vector<int> cells;
+
+public:
+  std::size_t allocate (std::size_t const n) {
+    auto const offset = cells.size();
+    cells.resize (offset + n);
+    return offset;
+  }
+  int* at (std::size_t const offset) { return cells.data() + offset; }
+  std::span<const int> span (std::size_t const offset, std::size_t const n) const { return { cells.data() + offset, n }; }
+  std::size_t used (void) const { return cells.size(); }
+  void reset (void) { cells.clear(); } // capacity stays, for the next session
+};
+
+// words.
+// composites defined at runtime by the definitor, private to a frame. bodies are flat compiled code, laid out
+// in frame's arena one after another, so executing a word walks one span. redefining a word keeps its atom
+// and writes the new body over the old one when it fits, else appends it. words compiled elsewhere keep a copy of the
+// old one. when abandoned cells outweigh live ones, arena is compacted, so redefinitions in a loop do not grow it.
+// every change of words takes a new epoch, unique among all frames, so compiled programs can tell what they saw
+std::atomic<std::uint64_t> word_epochs {0};
+
+class WORDS {
+  struct HASH { // transparent, lookups by string views make no temporary strings
+    typedef void is_transparent;
+    std::size_t operator() (std::string_view const s) const { return std::hash<std::string_view>() (s); }
+  };
+  std::unordered_map<std::string, Atom, HASH, std::equal_to<> > atoms; // symbol -> word atom
+  struct BODY { std::uint32_t offset = 0, size = 0, instructions = 0; PROOF proof; };
+  std::array<BODY, WORD_ATOMS> bodies {};
+  ARENA arena;
+  std::size_t live = 0; // cells of current bodies, the rest of arena is abandoned
+  std::uint64_t changed = 0; // epoch, zero while there are no words
+
+  void compact (void) {
+    std::vector<int> block;
+    block.reserve (live);
+    for (const auto& [symbol, atom] : atoms) {
+      auto& b = bodies [atom - FIRST_WORD];
+      auto const code = arena.span (b.offset, b.size);
+      b.offset = std::uint32_t (block.size()), block.insert (block.end(), code.begin(), code.end());
+    }
+    arena.reset();
+    std::copy (block.begin(), block.end(), arena.at (arena.allocate (block.size())));
+  }
+
+public:
+  Atom find (std::string_view const s) const {
+    if (atoms.empty()) return UNDEFINED;
+    auto const found = atoms.find (s);
+    return found != atoms.end() ? found->second : UNDEFINED;
+  }
+
+  std::span<const int> body (Atom const word) const {
+    auto const& b = bodies [word - FIRST_WORD];
+    return arena.span (b.offset, b.size);
+  }
+  const PROOF& proof (Atom const word) const { return bodies [word - FIRST_WORD].proof; }
+  std::size_t instructions (Atom const word) const { return bodies [word - FIRST_WORD].instructions; }
+
+  // bind symbol to a word with given body, or rebind it. UNDEFINED when word atoms are exhausted
+  Atom define (std::string_view const s, std::span<const int> const code, PROOF const proof) {
+    auto word = find (s);
+    std::size_t offset = 0;
+    if (word == UNDEFINED) {
+      if (atoms.size() == WORD_ATOMS) return UNDEFINED;
+      word = Atom (FIRST_WORD + atoms.size());
+      atoms.emplace (s, word);
+      offset = arena.allocate (code.size());
+    }
+    else {
+      auto const& old = bodies [word - FIRST_WORD];
+      live -= old.size;
+      offset = code.size() <= old.size ? old.offset : arena.allocate (code.size());
+    }
+    live += code.size();
+    std::copy (code.begin(), code.end(), arena.at (offset));
+    bodies [word - FIRST_WORD] = { std::uint32_t (offset), std::uint32_t (code.size()),
+                                   std::uint32_t (::instructions (code)), proof };
+    if (arena.used() > 2 * live + 1024) compact();
+    changed = ++word_epochs;
+    return word;
+  }
+
+  // forget all words at once, for session teardown say
+  void reset (void) { atoms.clear(), arena.reset(), live = 0, changed = 0; }
+
+  std::uint64_t epoch (void) const { return changed; }
+  std::size_t size (void) const { return atoms.size(); }
+  std::size_t cells (void) const { return arena.used(); }
+
+  template<typename F> void for_each (F f) const {
+    for (const auto& [symbol, atom] : atoms) f (std::string_view (symbol), atom);
+  }
+
+  // snapshots keep words as records, with bodies and names as two blocks, see snapshots.
+  // bodies replaced by redefinitions are left out, so the block is the arena compacted
+  struct RECORD { std::int32_t atom; std::uint32_t offset, size, name, length; };
+
+  std::vector<RECORD> records (std::vector<int>& block, std::string& names) const {
+    std::vector<RECORD> records;
+    for (const auto& [symbol, atom] : atoms) {
+      auto const code = body (atom);
+      records.push_back ({ atom, std::uint32_t (block.size()), std::uint32_t (code.size()),
+                           std::uint32_t (names.size()), std::uint32_t (symbol.size()) });
+      block.insert (block.end(), code.begin(), code.end()), names.append (symbol);
+    }
+    return records;
+  }
+
+  // words of a snapshot replace all words, when they make sense: word atoms dense from the first one, bodies inside
+  // the block, flat and of atoms in atomspace. bodies never hold what definitor refuses: unresolved symbols and
+  // definitions. proofs are not saved, they are verified again against this build
+  bool adopt (std::span<const RECORD> const records, std::span<const int> const block, std::string_view const names) {
+    if (records.size() > WORD_ATOMS) return false;
+    std::bitset<WORD_ATOMS> seen;
+    for (auto const& r : records) {
+      auto const word = std::size_t (r.atom - FIRST_WORD);
+      if (r.atom < FIRST_WORD || word >= records.size() || seen [word]) return false;
+      if (r.offset > block.size() || r.size > block.size() - r.offset || r.name > names.size() || r.length > names.size() - r.name)
+        return false;
+      auto const code = block.subspan (r.offset, r.size);
+      for (std::size_t i = 0; i < code.size(); i += 1 + operands_of (code [i]))
+        if (code [i] < 0 || code [i] >= int (FIRST_WORD) || code [i] == UNRESOLVED || code [i] == DEFINE
+            || i + operands_of (code [i]) >= code.size()) return false;
+      seen.set (word);
+    }
+    reset();
+    std::copy (block.begin(), block.end(), arena.at (arena.allocate (block.size())));
+    for (auto const& r : records) {
+      atoms.emplace (names.substr (r.name, r.length), Atom (r.atom));
+      auto const code = arena.span (r.offset, r.size);
+      bodies [r.atom - FIRST_WORD] = { r.offset, r.size, std::uint32_t (::instructions (code)), verify (code) };
+      live += r.size;
+    }
+    if (atoms.size() != records.size()) return reset(), false; // names repeat
+    compact(); // bodies of a forged image may overlap, redefinitions in place must not touch others
+    if (! records.empty()) changed = ++word_epochs;
+    return true;
+  }
+};
+
+const WORDS no_words; // for callers having no frame at hand
+
+// resource budgets.
+// hosts of many frames want none of them to take more than its share. a frame may have quotas: atoms executed,
+// depth of data stack and bytes of output, zero is unlimited. they are budgets of a unit of work, a line for shells,
+// refilled when host settles the unit. atoms are instructions of compiled code, so fused ones count once, and symbols
+// of outer interpreter. checks are amortized: atoms are charged per program or word body before it runs,
+// depth is the bound of the stack, which push compares anyway and proofs are checked against, output is counted by
+// its channel. a frame over quota stops at next program or word boundary, and the unit ends with a status, no more.
+// so does a confined frame whose work was ended by process control, but that is no error
+typedef enum : unsigned char { FRAME_OK, FRAME_ENDED, ATOMS_EXHAUSTED, DEPTH_EXHAUSTED, OUTPUT_EXHAUSTED } STATUS;
+
+constexpr std::string_view status_messages [] {
+  "", "work ended", "atoms quota exhausted", "data stack overflow", "output quota exhausted"
+};
+
+inline bool failed (STATUS const status) { return status > FRAME_ENDED; }
+
+// for hosts on a console
+inline void report_status (STATUS const status) {
+  if (failed (status)) [[unlikely]] std::cerr << "Error: frame " << status_messages [status] << "\n";
+}
+
+struct QUOTAS { std::size_t atoms = 0, depth = 0, output = 0; };
+
+// the exemplary frame of this toy. it comes after atoms, for it carries a profile of atoms it executes
+// there is no global frame. hosts have as many as they like, every execution path takes its frame explicitly
+class FRAME : public BASIC_FRAME<ARRAY_STACK<int, FRAME_STACK_CAPACITY> > {
+  QUOTAS quotas;
+  std::size_t atoms = 0; // charged since last settled
+  STATUS status = FRAME_OK; // first quota exhausted
+
+public:
+  [[no_unique_address]] std::conditional_t<profiling, PROFILE, NO_PROFILE> profile;
+  WORDS words; // defined at runtime by this frame
+  // process control of a confined frame does not leave the process, it ends frame's work and its host decides
+  bool confined = false;
+  bool ended = false, aborted = false; // work asked to end, abnormally
+  int exit_code = 0; // asked for by exit
+  // superinstructions executed, by atom from DUP_DUP. a trace of this frame for tuning fusions. native code does not count
+  std::array<std::size_t, SUPERINSTRUCTIONS> fused {};
+  void fused_one (Atom const atom) { ++fused [atom - DUP_DUP]; }
+
+  void limit (QUOTAS const& q) { quotas = q, data_stack.bound (q.depth), output.quota = q.output; }
+  const QUOTAS& limits (void) const { return quotas; }
+
+  // status of the unit so far. stack overflow counts against depth quota, even if it is just capacity
+  STATUS check (void) {
+    if (status == FRAME_OK) [[likely]] {
+      if (data_stack.overflowed) status = DEPTH_EXHAUSTED;
+      else if (output.exceeded()) status = OUTPUT_EXHAUSTED;
+      else if (ended) status = FRAME_ENDED;
+    }
+    return status;
+  }
+
+  // code of n atoms is about to run. false, when it must not
+  bool charge (std::size_t const n) {
+    if (check() != FRAME_OK) [[unlikely]] return false;
+    atoms += n;
+    if (quotas.atoms && atoms > quotas.atoms) [[unlikely]] return status = ATOMS_EXHAUSTED, false;
+    return true;
+  }
+
+  // end of unit: its status, and budgets refilled for the next one
+  STATUS settle (void) {
+    auto const result = check();
+    atoms = 0, status = FRAME_OK, data_stack.overflowed = false, output.produced = 0;
+    return result;
+  }
+};
+
 // primitives.
 // there are several strategies how to create executable primitives for frames, explored in this toy:
 // 1. absolute primitive functions, such as void functions of void, globally defined or compatible to std::function<void()> objects
@@ -121,15 +633,16 @@ typedef enum {
 // we will explore different mechanismi of constructing primitives: linkage, templates and lambda
 
 // underflow in stack arithmetic is a common error. we may use this helper often
-inline void report_underflow (void) {
-  std::cerr << "Error: frame data stack underflow" << std::endl;
+inline void report_underflow (class FRAME& frame) {
+  frame.profile.underflow();
+  std::cerr << "Error: frame data stack underflow\n";
 }
 
 // value accessor for arity operators. this helper detects data stack underflow but provides no serious handling
 inline auto take_dtos_from (class FRAME& frame) {
   if (frame.data_stack.empty()) {
-    report_underflow();
-    std::cerr << "Warning: frame enforces zero value to next operation" << std::endl;
+    report_underflow(frame);
+    std::cerr << "Warning: frame enforces zero value to next operation\n";
     return 0;
   }
   auto y = frame.data_stack.top();
@@ -137,26 +650,49 @@ inline auto take_dtos_from (class FRAME& frame) {
   return y;
 }
 
+// depth guard for operators working in place. one compare on the fast path.
+// on underflow, missing values are supplied as zeros under the bottom, reported same way take_dtos_from does,
+// so operators keep their semantics of zero enforcement
+inline void ensure_depth (class FRAME& frame, std::size_t const n) {
+  if (frame.data_stack.size() < n) [[unlikely]] {
+    auto const missing = n - frame.data_stack.size();
+    for (std::size_t i = 0; i < missing; ++i) {
+      report_underflow(frame);
+      std::cerr << "Warning: frame enforces zero value to next operation\n";
+    }
+    frame.data_stack.pad_bottom (missing);
+  }
+}
+
 // "global" primitives, obvious meanings. some do not use frame actually. this is indicated by dummmy argument
 
 void primitive_no_operation (class FRAME& dummy) {} // possibly traceable
 
-void primitive_hello (class FRAME& dummy) {
-  std::cout << "Hello, world!" << std::endl;
+// output is written to frame's channel, so those use frame after all. process control flushes it before leaving.
+// a confined frame does not own the process, it just ends its work and its host takes care
+void primitive_hello (class FRAME& frame) {
+  frame.output << "Hello, world!\n";
 }
 
-void primitive_abort (class FRAME& dummy) {
+void primitive_abort (class FRAME& frame) {
+  if (frame.confined) { frame.ended = frame.aborted = true; return; }
+  frame.output.flush();
   abort(); // default trap usually dumps core, clang c++ on FreeBSD
 }
 
-void primitive_help (class FRAME& dummy) {
-  std::cout << "some helpful information here..." << std::endl;
+void primitive_help (class FRAME& frame) {
+  frame.output << "some helpful information here...\n";
 }
 
-void primitive_quit (class FRAME& dummy) {  exit(0); }
+void primitive_quit (class FRAME& frame) {
+  if (frame.confined) { frame.ended = true; return; }
+  frame.output.flush(), exit(0);
+}
 
 void primitive_exit (class FRAME& frame) {
   auto exitcode = take_dtos_from (frame);  // exit command expects a platform defined process exit value on frame's data stack
+  if (frame.confined) { frame.ended = true, frame.exit_code = exitcode; return; }
+  frame.output.flush();
   exit(exitcode);
 }
 
@@ -170,27 +706,27 @@ template <int C> void primitive_constant (class FRAME& frame) {
 // data stack manipulators
 void primitive_DROP (class FRAME& frame) {
   if (frame.data_stack.empty()) {
-    report_underflow();
+    report_underflow(frame);
     return;
   } frame.data_stack.pop();  
 }
 
 void primitive_DUP (class FRAME& frame) {
   if (frame.data_stack.empty()) {
-    report_underflow();
-    std::cerr << "Warning: missing value, duplication operation ignored by frame" << std::endl;
+    report_underflow(frame);
+    std::cerr << "Warning: missing value, duplication operation ignored by frame\n";
     return;
   } frame.data_stack.push (frame.data_stack.top());
 }
 
 void primitive_SWAP (class FRAME& frame) { 
-  auto a = take_dtos_from (frame), b = take_dtos_from (frame);
-  frame.data_stack.push (a), frame.data_stack.push (b); // naive and inefficient
+  ensure_depth (frame, 2);
+  std::swap (frame.data_stack [0], frame.data_stack [1]);
 }
 
 void primitive_OVER (class FRAME& frame) { 
-  auto a = take_dtos_from (frame), b = take_dtos_from (frame);
-  frame.data_stack.push (b), frame.data_stack.push (a), frame.data_stack.push (b); // naive and inefficient
+  ensure_depth (frame, 2);
+  frame.data_stack.push (frame.data_stack [1]);
 }
 
 void primitive_DEPTH (class FRAME& frame) { 
@@ -200,30 +736,31 @@ void primitive_DEPTH (class FRAME& frame) {
 // generic primitive. function object compatible lambda pattern. unused, for now. this formulation works since c+11
 std::function<void (class FRAME& frame) > primitive_generic = [] (class FRAME& frame) { return; };
 
+// binary operators work in place: second cell becomes the result, top cell is dropped
 void primitive_PLUS (class FRAME& frame) {
-  auto a = take_dtos_from (frame), b = take_dtos_from (frame);
-  frame.data_stack.push (a+b);
+  ensure_depth (frame, 2);
+  frame.data_stack [1] += frame.data_stack [0], frame.data_stack.pop();
 }
 
 void primitive_MINUS (class FRAME& frame) {
-  auto a = take_dtos_from (frame), b = take_dtos_from (frame);
-  frame.data_stack.push (b-a); // this is gforth's '-' semantics
+  ensure_depth (frame, 2);
+  frame.data_stack [1] -= frame.data_stack [0], frame.data_stack.pop(); // this is gforth's '-' semantics
 }
 
 void primitive_MULT (class FRAME& frame) {
-  auto a = take_dtos_from (frame), b = take_dtos_from (frame);
-  frame.data_stack.push (a*b); 
+  ensure_depth (frame, 2);
+  frame.data_stack [1] *= frame.data_stack [0], frame.data_stack.pop();
 }
 
 void primitive_DIV (class FRAME& frame) {
-  auto a = take_dtos_from (frame), b = take_dtos_from (frame);
-  frame.data_stack.push (b/a); // this is gforth's '/' semantics.
+  ensure_depth (frame, 2);
+  frame.data_stack [1] /= frame.data_stack [0], frame.data_stack.pop(); // this is gforth's '/' semantics.
   // we do not handle division by zero here in demonstrator. beware of funny ARM CPUs which don't either
 }
 
 void primitive_DOT (class FRAME& frame) { // shows top of data stack in current base
   auto a = take_dtos_from (frame);
-  std::cout << std::setbase(frame.base) << a << std::endl;
+  frame.output.number (a, frame.base), frame.output << '\n';
 }
 
 // numeric base is implemented as frame member data. we template by valid options directly
@@ -243,12 +780,87 @@ void primitive_FLAG_RESET(class FRAME& frame) { frame._FLAG_RESET(); }
 void primitive_FLAG_QUERY(class FRAME& frame) { frame._FLAG_QUERY(); }
 void primitive_FLAG_STORE(class FRAME& frame) { frame._FLAG_STORE(); }
 
-// just a forward declaration (we otherwise use no unnecessary prototypes in this toy)
+// superinstructions. each does the work of a sequence of primitives in one dispatch.
+// when stack depth does not suffice, they fall back to the very sequence, so diagnostics and zero enforcement stay the same
+void primitive_DUP_DUP (class FRAME& frame) {
+  frame.fused_one (DUP_DUP);
+  if (frame.data_stack.empty()) [[unlikely]]
+    return primitive_DUP (frame), primitive_DUP (frame);
+  frame.data_stack.push (frame.data_stack.top()), frame.data_stack.push (frame.data_stack.top());
+}
+
+void primitive_OVER_OVER (class FRAME& frame) {
+  frame.fused_one (OVER_OVER);
+  if (frame.data_stack.size() < 2) [[unlikely]]
+    return primitive_OVER (frame), primitive_OVER (frame);
+  frame.data_stack.push (frame.data_stack [1]), frame.data_stack.push (frame.data_stack [1]);
+}
+
+void primitive_SWAP_DROP (class FRAME& frame) {
+  frame.fused_one (SWAP_DROP);
+  if (frame.data_stack.size() < 2) [[unlikely]]
+    return primitive_SWAP (frame), primitive_DROP (frame);
+  frame.data_stack [1] = frame.data_stack [0], frame.data_stack.pop();
+}
+
+// this one carries an operand, so it is executed by program executor, not via vocabulary.
+// it needs the free cell its literal and PLUS would push to, so a full stack overflows just like unfused
+inline void execute_PLUS_LITERAL (class FRAME& frame, int const n) {
+  frame.fused_one (PLUS_LITERAL);
+  if (frame.data_stack.empty() || frame.data_stack.full()) [[unlikely]]
+    return frame.data_stack.push (n), primitive_PLUS (frame);
+  frame.data_stack.top() += n;
+}
+
+// unchecked primitives. same operations with no guards at all, for code whose stack effect is proven safe
+// against the depth it starts on. underflow and overflow cannot happen there, so there is nothing to check
+template <int C> void unchecked_constant (class FRAME& frame) { frame.data_stack.push_unchecked (C); }
+
+void unchecked_DROP (class FRAME& frame) { frame.data_stack.pop(); }
+void unchecked_DUP  (class FRAME& frame) { frame.data_stack.push_unchecked (frame.data_stack.top()); }
+void unchecked_SWAP (class FRAME& frame) { std::swap (frame.data_stack [0], frame.data_stack [1]); }
+void unchecked_OVER (class FRAME& frame) { frame.data_stack.push_unchecked (frame.data_stack [1]); }
+void unchecked_DEPTH(class FRAME& frame) { frame.data_stack.push_unchecked (frame.data_stack.size()); }
+
+void unchecked_PLUS (class FRAME& frame) { frame.data_stack [1] += frame.data_stack [0], frame.data_stack.pop(); }
+void unchecked_MINUS(class FRAME& frame) { frame.data_stack [1] -= frame.data_stack [0], frame.data_stack.pop(); }
+void unchecked_MULT (class FRAME& frame) { frame.data_stack [1] *= frame.data_stack [0], frame.data_stack.pop(); }
+void unchecked_DIV  (class FRAME& frame) { frame.data_stack [1] /= frame.data_stack [0], frame.data_stack.pop(); }
+
+void unchecked_DOT (class FRAME& frame) {
+  frame.output.number (frame.data_stack.top(), frame.base), frame.output << '\n';
+  frame.data_stack.pop();
+}
+
+void unchecked_DUP_DUP (class FRAME& frame) {
+  frame.fused_one (DUP_DUP);
+  auto const a = frame.data_stack.top();
+  frame.data_stack.push_unchecked (a), frame.data_stack.push_unchecked (a);
+}
+void unchecked_OVER_OVER (class FRAME& frame) {
+  frame.fused_one (OVER_OVER);
+  frame.data_stack.push_unchecked (frame.data_stack [1]), frame.data_stack.push_unchecked (frame.data_stack [1]);
+}
+void unchecked_SWAP_DROP (class FRAME& frame) {
+  frame.fused_one (SWAP_DROP);
+  frame.data_stack [1] = frame.data_stack [0], frame.data_stack.pop();
+}
+
+// just forward declarations (we otherwise use no unnecessary prototypes in this toy)
 void primitive_symbols (class FRAME& frame);
+void primitive_fusions (class FRAME& frame);
+void primitive_stats (class FRAME& frame);
+void primitive_stats_reset (class FRAME& frame);
+void primitive_define (class FRAME& frame);
 
-// composites must have controlling primitive for indirection, it binds a composite definition to atom
-// this is the common composites controlling primitive forward declaration
+// forgetting words is a bulk reset of frame's arena
+void primitive_forget (class FRAME& frame) { frame.words.reset(); }
+
+// composites defined at runtime must have controlling primitive for indirection, it binds a composite definition to atom
+// this is the common composites controlling primitive forward declaration. built-in composites need none, see below
 template<Atom> void primitive_composite  (class FRAME& frame);
+// words have one too, it finds the body in frame executing it
+template<Atom> void primitive_word  (class FRAME& frame);
 
 // for inner execution, primitives need to be aggregated in their own kind of vocabulary (different structure from symbolic dictionary)
 // because in a serious frame, some of them may be not exposed to outer or toplevel symbolic interpreters
@@ -257,7 +869,11 @@ template<Atom> void primitive_composite  (class FRAME& frame);
 // also note UNDEFINED atom bounds to primitive but needs no explicit binding from symbols.
 // it emerges every time an unknown symbol is inserted into dictionary, as its safe closure of execution
 
-std::map<Atom, std::function<void (class FRAME&)> > primitives_vocabulary {
+// inner interpreter needs nothing more than a plain function pointer per atom. no functor copies, no allocations
+typedef void (*Primitive) (class FRAME&);
+
+// built-in bindings, as a compile time constant list
+constexpr std::pair<Atom, Primitive> builtin_primitives [] {
    { UNDEFINED, primitive_no_operation },
    // process & user
    { HELLO, primitive_hello },
@@ -290,65 +906,374 @@ std::map<Atom, std::function<void (class FRAME&)> > primitives_vocabulary {
    { FLAG_QUERY, primitive_FLAG_QUERY },
    { FLAG_STORE, primitive_FLAG_STORE },
    { SYMBOLS, primitive_symbols },
-   // controlling proxies for composites
-   { _3HELLO, primitive_composite<_3HELLO> },
-   { _2DUP,   primitive_composite<_2DUP> },
-   { _2DROP,  primitive_composite<_2DROP> },
-   { _2OVER,  primitive_composite<_2OVER> }
+   { DEFINE,  primitive_define },
+   { FORGET,  primitive_forget },
+   { FUSIONS, primitive_fusions },
+   { STATS,       primitive_stats },
+   { STATS_RESET, primitive_stats_reset },
+   // superinstructions
+   { DUP_DUP,   primitive_DUP_DUP },
+   { OVER_OVER, primitive_OVER_OVER },
+   { SWAP_DROP, primitive_SWAP_DROP },
+};
+
+// compile-time composites.
+// built-in composites are known to the compiler whole, so they need no indirection and no loop over their atoms.
+// composite<atoms...> expands into a chain of direct calls of the primitives, which the compiler may inline
+// like any handwritten c++. numerals are LITERAL atoms with their value in the following cell.
+// atoms are looked up among built-in primitives above, so composites stay flat by construction: a composite
+// atom in a composite does not compile. its flat body is kept for compiled programs, they inline it
+constexpr Primitive builtin_primitive (int const atom) {
+  for (const auto& [a, primitive] : builtin_primitives)
+    if (a == atom) return primitive;
+  return nullptr;
+}
+
+template<int... CELLS> class composite {
+  static constexpr int cells [] { CELLS... };
+
+  template<std::size_t I> static void run (class FRAME& frame) {
+    if constexpr (I < sizeof... (CELLS)) {
+      constexpr int atom = cells [I];
+      if constexpr (atom == LITERAL) {
+        frame.data_stack.push (cells [I + 1]);
+        return run<I + 2> (frame);
+      }
+      else if constexpr (atom == PLUS_LITERAL) {
+        execute_PLUS_LITERAL (frame, cells [I + 1]);
+        return run<I + 2> (frame);
+      }
+      else {
+        constexpr Primitive primitive = builtin_primitive (atom);
+        static_assert (primitive != nullptr, "composites are flat, built-in primitives only");
+        auto const start = frame.profile.start();
+        primitive (frame); // direct call
+        frame.profile.record (atom, start);
+        return run<I + 1> (frame);
+      }
+    }
+  }
+
+public:
+  static constexpr std::array<int, sizeof... (CELLS)> body { CELLS... };
+  static void primitive (class FRAME& frame) { run<0> (frame); }
+};
+
+// composites examples. static.
+typedef composite<DUP, DUP> definition_composite_2DUP;
+typedef composite<DROP, DROP> definition_composite_2DROP;
+typedef composite<OVER, OVER> definition_composite_2OVER;
+typedef composite<HELLO, HELLO, HELLO> definition_composite_3HELLO;
+typedef composite<LITERAL, 1000, MULT> definition_composite_KILO;
+
+// they bind to their atoms just like primitives do
+constexpr std::pair<Atom, Primitive> builtin_composites [] {
+   { _3HELLO, definition_composite_3HELLO::primitive },
+   { _2DUP,   definition_composite_2DUP::primitive },
+   { _2DROP,  definition_composite_2DROP::primitive },
+   { _2OVER,  definition_composite_2OVER::primitive },
+   { KILO,    definition_composite_KILO::primitive }
 };
 
+// the vocabulary itself is a dense table indexed by atom. it is laid out by the compiler from bindings above,
+// every atom not bound there falls back to no operation, just like UNDEFINED does. word atoms are bound all,
+// to their controlling primitives
+template<std::size_t... I>
+constexpr void bind_words (std::array<Primitive, ATOMSPACE>& vocabulary, std::index_sequence<I...>) {
+  ((vocabulary [FIRST_WORD + I] = primitive_word<Atom (FIRST_WORD + I)>), ...);
+}
+
+template<std::size_t N>
+constexpr void bind (std::array<Primitive, ATOMSPACE>& vocabulary, const std::pair<Atom, Primitive> (&bindings) [N]) {
+  for (const auto& [atom, primitive] : bindings)
+    vocabulary [atom] = primitive;
+}
+
+constexpr auto builtin_vocabulary (void) {
+  std::array<Primitive, ATOMSPACE> vocabulary {};
+  vocabulary.fill (primitive_no_operation);
+  bind (vocabulary, builtin_primitives), bind (vocabulary, builtin_composites);
+  bind_words (vocabulary, std::make_index_sequence<WORD_ATOMS>());
+  return vocabulary;
+}
+
+constinit std::array<Primitive, ATOMSPACE> primitives_vocabulary = builtin_vocabulary();
+
+// unchecked vocabulary is the same table, but with unchecked primitives where there are some.
+// the rest guard themselves as usual, it costs them nothing more on proven code
+constexpr std::pair<Atom, Primitive> unchecked_primitives [] {
+   { ZERO,  unchecked_constant<0> }, { ONE,   unchecked_constant<1> },
+   { TWO,   unchecked_constant<2> }, { THREE, unchecked_constant<3> },
+   { DROP,  unchecked_DROP }, { DUP,   unchecked_DUP },   { SWAP, unchecked_SWAP }, { OVER, unchecked_OVER },
+   { DEPTH, unchecked_DEPTH },
+   { PLUS,  unchecked_PLUS }, { MINUS, unchecked_MINUS }, { MULT, unchecked_MULT }, { DIV,  unchecked_DIV },
+   { DOT,   unchecked_DOT },
+   { DUP_DUP, unchecked_DUP_DUP }, { OVER_OVER, unchecked_OVER_OVER }, { SWAP_DROP, unchecked_SWAP_DROP },
+};
+
+constinit std::array<Primitive, ATOMSPACE> unchecked_vocabulary = [] {
+  auto vocabulary = builtin_vocabulary();
+  bind (vocabulary, unchecked_primitives);
+  return vocabulary;
+} ();
+
+// every built-in primitive and composite declares its stack effect. the compiler checks
+template<std::size_t N>
+constexpr bool effects_declared (const std::pair<Atom, Primitive> (&bindings) [N]) {
+  for (const auto& [atom, primitive] : bindings)
+    if (std::find_if (std::begin (builtin_effects), std::end (builtin_effects),
+                      [atom] (const auto& e) { return e.first == atom; }) == std::end (builtin_effects))
+      return false;
+  return true;
+}
+static_assert (effects_declared (builtin_primitives) && effects_declared (builtin_composites),
+               "built-in atom without declared stack effect");
+
+// vocabulary still accepts bindings at runtime, for atoms anywhere in the atomspace.
+// with no effect declared, code using such primitive is never proven and always runs checked
+inline void register_primitive (Atom const atom, Primitive const primitive, EFFECT const effect = {}) {
+  primitives_vocabulary [atom] = unchecked_vocabulary [atom] = primitive;
+  effects [atom] = effect;
+}
+
 // inner execution.
-// execute a primitive found by its atom against the (currently global) frame
-void execute_primitive (Atom const atom) {
-  auto primitive_function = primitives_vocabulary [atom];
-  primitive_function(frame); // just do it
+// execute a primitive found by its atom against a frame
+inline void execute_primitive (class FRAME& frame, Atom const atom) {
+  auto const start = frame.profile.start();
+  primitives_vocabulary [atom] (frame); // just do it
+  frame.profile.record (atom, start);
+}
+
+// programs.
+// interpreting resolves every symbol again and again. a program is a line translated once into atoms,
+// to be executed many times without any symbolics involved. numerals become LITERAL atoms with value inline,
+// symbols failing to resolve become UNRESOLVED atoms referring to their text, so warnings are not lost on replays
+// native code of a program takes frame and its stack pointer, see jit tier
+typedef void (*NATIVE) (class FRAME&, int**);
+
+#ifdef FT_JIT
+constexpr bool jitting = true;
+#else
+constexpr bool jitting = false;
+#endif
+
+class PROGRAM {
+public:
+  std::vector<int> code; // atoms, pseudo atoms followed by their operand cell
+  std::vector<std::string> unresolved; // texts of undefined symbols, indexed by UNRESOLVED operands
+  PROOF proof; // verified stack effect of code, when optimized
+  std::size_t instructions = 0; // of code, when optimized. budgets are charged by these
+  bool defines = false; // line uses definitor. it must be interpreted, replaying would not define anything
+  std::size_t runs = 0; // executions counted by its owner, for promotion to native code
+  NATIVE native = nullptr; // same code compiled by jit tier, once promoted
+};
+
+// code executor is the inner interpreter loop. pseudo atoms are handled here, everything else is dispatched.
+// code is a span, of a program or of a word body in frame's arena. only programs have unresolved symbols
+void execute_code (class FRAME& frame, std::span<const int> const code, std::span<const std::string> const unresolved = {}) {
+  for (std::size_t i = 0; i < code.size(); ++i) {
+    switch (code [i]) {
+    case LITERAL: {
+      auto const start = frame.profile.start();
+      frame.data_stack.push (code [++i]);
+      frame.profile.record (LITERAL, start);
+      break;
+    }
+    case PLUS_LITERAL: {
+      auto const start = frame.profile.start();
+      execute_PLUS_LITERAL (frame, code [++i]);
+      frame.profile.record (PLUS_LITERAL, start);
+      break;
+    }
+    case UNRESOLVED:
+      frame.profile.undefined_symbol();
+      std::cerr << "Warning: undefined symbol " << '"' << unresolved [code [++i]] << "\"\n";
+      break;
+    default:
+      execute_primitive (frame, Atom (code [i]));
+    }
+  }
+}
+
+// unchecked executor, for code proven safe against current depth. with no guards, stack and arithmetic atoms
+// are a few instructions each, so they are inlined right here instead of dispatched. profile included
+void execute_unchecked (class FRAME& frame, std::span<const int> const code) {
+  for (std::size_t i = 0; i < code.size(); ++i) {
+    auto const start = frame.profile.start();
+    int const atom = code [i];
+    switch (atom) {
+    case LITERAL:      frame.data_stack.push_unchecked (code [++i]); break;
+    case PLUS_LITERAL: frame.fused_one (PLUS_LITERAL), frame.data_stack.top() += code [++i]; break;
+    case DROP:      unchecked_DROP (frame); break;
+    case DUP:       unchecked_DUP (frame); break;
+    case SWAP:      unchecked_SWAP (frame); break;
+    case OVER:      unchecked_OVER (frame); break;
+    case PLUS:      unchecked_PLUS (frame); break;
+    case MINUS:     unchecked_MINUS (frame); break;
+    case MULT:      unchecked_MULT (frame); break;
+    case DUP_DUP:   unchecked_DUP_DUP (frame); break;
+    case OVER_OVER: unchecked_OVER_OVER (frame); break;
+    case SWAP_DROP: unchecked_SWAP_DROP (frame); break;
+    default:        unchecked_vocabulary [atom] (frame);
+    }
+    frame.profile.record (atom, start);
+  }
+}
+
+// programs and words run unchecked whenever their proof holds for the stack they meet, within its bound.
+// promoted programs run native then. both are charged to frame's atoms budget first, not run when over
+void execute_program (class FRAME& frame, const PROGRAM& program) {
+  if (! frame.charge (program.instructions)) [[unlikely]] return;
+  if (program.proof.holds (frame.data_stack.size(), frame.data_stack.limit())) {
+    if (jitting && program.native) program.native (frame, &frame.data_stack.pointer());
+    else execute_unchecked (frame, program.code);
+  }
+  else execute_code (frame, program.code, program.unresolved);
+}
+
+template<Atom a> void primitive_word (class FRAME& frame) {
+  auto const body = frame.words.body (a);
+  if (! frame.charge (frame.words.instructions (a))) [[unlikely]] return;
+  if (frame.words.proof (a).holds (frame.data_stack.size(), frame.data_stack.limit()))
+    execute_unchecked (frame, body);
+  else execute_code (frame, body);
+}
+
+// optimizer.
+// peephole pass fusing frequent sequences of atoms into superinstructions. it runs over flattened code,
+// so sequences spanning composite boundaries fuse as well. rewrites happen once per compilation, which says
+// little of their worth, so frames count superinstructions they execute instead, to tune the set on real traces
+constexpr std::string_view fusion_names [SUPERINSTRUCTIONS] {
+  "dup dup", "over over", "swap drop", "constant plus" // the last one may stand for several constants summed up
+};
+
+// plain pairs of atoms, fused into a superinstruction without operand
+constexpr struct { Atom first, second, fused; } fusion_pairs [] {
+  { DUP,  DUP,  DUP_DUP },
+  { OVER, OVER, OVER_OVER },
+  { SWAP, DROP, SWAP_DROP },
+};
+
+void optimize (PROGRAM& program) {
+  auto const& code = program.code;
+  std::vector<int> fused; fused.reserve (code.size());
+  std::size_t last = 0; // start of last instruction emitted, valid when fused is not empty
+
+  for (std::size_t i = 0; i < code.size(); ) {
+    int const a = code [i];
+    std::size_t const next = i + 1 + operands_of (a);
+    int const b = next < code.size() ? code [next] : UNDEFINED; // UNDEFINED never fuses
+
+    if (b == PLUS && ((a >= ZERO && a <= THREE) || a == LITERAL)) { // constant followed by PLUS
+      int const n = a == LITERAL ? code [i + 1] : a - ZERO;
+      i = next + 1;
+      if (! fused.empty() && fused [last] == PLUS_LITERAL) { // and that follows another one, sum them up
+        fused [last + 1] = int (unsigned (fused [last + 1]) + unsigned (n)); // wrapping, as int arithmetic on targets does
+        continue;
+      }
+      last = fused.size(), fused.push_back (PLUS_LITERAL), fused.push_back (n);
+      continue;
+    }
+    auto const pair = std::find_if (std::begin (fusion_pairs), std::end (fusion_pairs),
+                                    [a, b] (const auto& f) { return f.first == a && f.second == b; });
+    if (pair != std::end (fusion_pairs)) {
+      i = next + 1;
+      last = fused.size(), fused.push_back (pair->fused);
+      continue;
+    }
+    last = fused.size(), fused.insert (fused.end(), code.begin() + i, code.begin() + next), i = next;
+  }
+  program.code.swap (fused);
+}
+
+// fusions primitive dumps how many times frame executed each superinstruction so far
+void primitive_fusions (class FRAME& frame) {
+  frame.output << "Superinstructions executed: \n";
+  for (std::size_t i = 0; i < SUPERINSTRUCTIONS; ++i) {
+    frame.output << '"' << fusion_names [i] << "\" -> ";
+    frame.output << std::string_view (std::to_string (frame.fused [i])) << '\n';
+  }
 }
 
 // composites.
 // Composites represent code compression, with code defined as a sequence of atoms
-// built-in composites definitions are autoconstructed as std::initializer_list of their respective atoms
+// built-in composites definitions are template argument lists of their respective atoms, see compile-time composites.
 // this is orthodox c++, not some fancy trick. actually, one of original motivations for this project
 // those lists of atoms can be executed similar way as primitives, without need of symbolics interpretation
-// while it is possible to construct initializers directly from c++ functions references, this approach is more readable
+// while it is possible to construct definitions directly from c++ functions references, this approach is more readable
 // in production, composites are good candidate for using iterable polymorphic containers
 
-// composites examples. static.
-auto definition_composite_2DUP = { DUP, DUP };
-auto definition_composite_2DROP = { DROP, DROP };
-auto definition_composite_2OVER = { OVER, OVER };
-auto definition_composite_3HELLO = { HELLO, HELLO, HELLO };
-
 // because of a level of indirection, composites need their own execution model
 // in our model, composites are flat, no composite recursions in composite definitions allowed. this is by design
 // note we also don't have a flow control. not having this provides determinism
 // that means, no infinite loops insidiously lurking hidden in symbolics, also by design
-void execute_composite (std::initializer_list<Atom> composite) { // std::initializer_list<int>
-  std::for_each (composite.begin(), composite.end(), [](const Atom& a) {
-    execute_primitive ( a ); // :reconsider recursion possibility
-  });
+// flatness is ensured by construction: a composite mentioned in definition is expanded into its own flat body,
+// once, when defined. so composites are stored as optimized programs of primitives only, and compiled programs
+// inline them the same way. definitions are copied, so no initializer lists are referenced after definition
+
+// let's construct some other vocabulary, of composites. dense, indexed by atom like primitives are.
+// an empty body means the atom is not a composite
+std::array<PROGRAM, ATOMSPACE> composites_vocabulary;
+
+inline bool is_composite (int const atom) { return ! composites_vocabulary [atom].code.empty(); }
+
+// definition is a list of cells: atoms, and operands following those which carry them
+void define_composite (Atom const composite, std::span<const int> const definition) {
+  PROGRAM body;
+  for (auto cell = definition.begin(); cell != definition.end(); ++cell) {
+    int const atom = *cell;
+    if (is_composite (atom)) {
+      auto const& expansion = composites_vocabulary [atom].code;
+      body.code.insert (body.code.end(), expansion.begin(), expansion.end());
+      continue;
+    }
+    body.code.push_back (atom);
+    for (auto n = operands_of (atom); n && cell + 1 != definition.end(); --n)
+      body.code.push_back (*++cell);
+  }
+  optimize (body);
+  body.proof = verify (body.code), body.instructions = instructions (body.code);
+  auto const declared = effects [composite];
+  if (! body.proof.known || declared.in != body.proof.needs || declared.out != body.proof.needs + body.proof.net)
+    std::cerr << "Warning: composite " << int (composite) << " does not have its declared stack effect\n";
+  composites_vocabulary [composite] = std::move (body);
+}
+
+// or a list of atoms, when defined at runtime
+template<typename CELL> void define_composite (Atom const composite, std::initializer_list<CELL> const definition) {
+  std::vector<int> const cells (definition.begin(), definition.end());
+  define_composite (composite, std::span<const int> (cells));
 }
 
-// let's construct some other vocabulary, of composites
-std::map<Atom, std::initializer_list<Atom>  > composites_vocabulary {
-  { _3HELLO, definition_composite_3HELLO },
-  { _2DUP,   definition_composite_2DUP },
-  { _2DROP,  definition_composite_2DROP },
-  { _2OVER,  definition_composite_2OVER }
+// built-in composites, defined before any execution may happen
+const bool builtin_composites_defined = [] {
+  define_composite (_3HELLO, definition_composite_3HELLO::body);
+  define_composite (_2DUP,   definition_composite_2DUP::body);
+  define_composite (_2DROP,  definition_composite_2DROP::body);
+  define_composite (_2OVER,  definition_composite_2OVER::body);
+  define_composite (KILO,    definition_composite_KILO::body);
 // be careful of declarations such as:
-// { _4HELLO, { HELLO, HELLO, HELLO, HELLO } }, 
-// for, it compiles well on older compilers but on some ABIs leads to funny dangling references, therefore crashes on executing.
-// later versions of C++23 standard may provide better diagnostic or functionality, situation possibly solvable by lambda captures  
-};
+// define_composite (_4HELLO, { HELLO, HELLO, HELLO, HELLO });
+// it is safe now, for the body is copied. with composites referencing initializer lists, it used to compile well
+// on older compilers but on some ABIs led to funny dangling references, therefore crashes on executing.
+  return true;
+} ();
+
+// composite atom is profiled by its dispatcher, like any other atom. recording here too would count it twice
+void execute_composite (class FRAME& frame, Atom const composite) {
+  execute_program (frame, composites_vocabulary [composite]);
+}
 
-// now comes the definition of controlling primitive for composites
+// now comes the definition of controlling primitive for composites defined at runtime
 template<Atom a> void primitive_composite  (class FRAME& frame) {
-  execute_composite ( composites_vocabulary [ a ]);
+  execute_composite (frame, a);
 }
 
 // outer execution.
 // dictionary for outer interpreter translates outer symbols (strings) to inner atoms. may contain aliases to same atoms or localized symbols
 // current model allows mixup of primitives and composites in outer dictionary, which we demonstrate here
-std::map<std::string, Atom> outer_dictionary {
+// built-in symbols are compile time constants, so are their bindings
+constexpr std::pair<std::string_view, Atom> builtin_symbols [] {
   { "zero",  ZERO  }, { "0",     ZERO   },
   { "one",   ONE   }, { "1",     ONE    },
   { "two",   TWO   }, { "2",     TWO    },
@@ -366,78 +1291,1407 @@ std::map<std::string, Atom> outer_dictionary {
   { "set",   FLAG_SET }, { "reset", FLAG_RESET }, { "query?", FLAG_QUERY }, { "store!", FLAG_STORE },
   { "hello", HELLO },
   { "exit",  EXIT   }, { "quit", QUIT   }, { "abort", ABORT }, { "help", HELP },
-  { "symbols", SYMBOLS },
-  { "3hello", _3HELLO }
+  { "symbols", SYMBOLS }, { "fusions", FUSIONS },
+  { ":", DEFINE }, { "forget", FORGET },
+  { "stats", STATS }, { "stats-reset", STATS_RESET },
+  { "3hello", _3HELLO }, { "kilo", KILO }
 }; // extensible ad nauseam
 
+// symbol hashing. FNV-1a with a seedable offset basis, so the compiler may search for a seed hashing built-ins perfectly
+constexpr std::uint32_t hash_symbol (std::string_view const s, std::uint32_t h = 2166136261u) {
+  for (unsigned char const c : s)
+    h = (h ^ c) * 16777619u;
+  return h;
+}
+
+// perfect hash of built-in symbols: a seed and a slot table without collisions, both found by the compiler.
+// slots hold index+1 of a built-in symbol, zero marks an empty slot
+constexpr std::size_t BUILTIN_SLOTS = 512; // power of two, comfortably sparse so the seed search stays short
+
+struct PERFECT_HASH {
+  std::uint32_t seed;
+  std::array<std::uint8_t, BUILTIN_SLOTS> slots;
+};
+
+template<std::size_t N>
+constexpr PERFECT_HASH perfect_hash_of (const std::pair<std::string_view, Atom> (&symbols) [N]) {
+  static_assert (N < 256, "too many built-in symbols for byte slots");
+  for (std::uint32_t seed = 2166136261u; ; ++seed) {
+    PERFECT_HASH ph { seed, {} };
+    std::size_t i = 0;
+    for (; i < N; ++i) {
+      auto& slot = ph.slots [hash_symbol (symbols [i].first, seed) & (BUILTIN_SLOTS - 1)];
+      if (slot) break; // collision, next seed
+      slot = i + 1;
+    }
+    if (i == N) return ph;
+  } // duplicate symbols would loop until the compiler gives up evaluating. that's a diagnostic too
+}
+
+// the dictionary. built-in symbols are found by perfect hash, symbols added at runtime live in an open addressing table.
+// lookups take string views, so no temporary strings are ever made. runtime symbols shadow built-in ones.
+// UNDEFINED atom is never bound to a symbol, therefore it doubles as "not found" result
+class DICTIONARY {
+  static constexpr PERFECT_HASH builtin = perfect_hash_of (builtin_symbols);
+
+  struct ENTRY {
+    std::uint32_t hash = 0;
+    Atom atom = UNDEFINED; // UNDEFINED marks an empty slot
+    std::string symbol;
+  };
+  std::vector<ENTRY> table; // capacity is zero or a power of two, load kept below one half
+  std::size_t count = 0;
+
+  static Atom find_builtin (std::string_view const s) {
+    auto const slot = builtin.slots [hash_symbol (s, builtin.seed) & (BUILTIN_SLOTS - 1)];
+    if (slot && builtin_symbols [slot - 1].first == s)
+      return builtin_symbols [slot - 1].second;
+    return UNDEFINED;
+  }
+
+  std::size_t probe (std::string_view const s, std::uint32_t const hash) const {
+    auto const mask = table.size() - 1;
+    auto i = hash & mask;
+    while (table [i].atom != UNDEFINED && (table [i].hash != hash || table [i].symbol != s))
+      i = (i + 1) & mask;
+    return i;
+  }
+
+  void grow (void) {
+    std::vector<ENTRY> old (table.size() ? table.size() * 2 : 16);
+    old.swap (table);
+    for (auto& e : old)
+      if (e.atom != UNDEFINED)
+        table [probe (e.symbol, e.hash)] = std::move (e);
+  }
+
+public:
+  Atom find (std::string_view const s) const {
+    if (count) { // runtime symbols first, they may shadow
+      auto const& e = table [probe (s, hash_symbol (s))];
+      if (e.atom != UNDEFINED) return e.atom;
+    }
+    return find_builtin (s);
+  }
+
+  bool contains (std::string_view const s) const { return find (s) != UNDEFINED; }
+
+  // bind a symbol at runtime, or rebind it. binding to UNDEFINED is meaningless and ignored
+  void insert (std::string_view const s, Atom const atom) {
+    if (atom == UNDEFINED) return;
+    if (2 * (count + 1) > table.size()) grow();
+    auto const hash = hash_symbol (s);
+    auto& e = table [probe (s, hash)];
+    if (e.atom == UNDEFINED)
+      e.hash = hash, e.symbol = s, ++count;
+    e.atom = atom;
+  }
+
+  // visit every visible symbol binding, built-in ones not shadowed first, then runtime ones. order is otherwise unspecified
+  template<typename F> void for_each (F f) const {
+    for (const auto& [symbol, atom] : builtin_symbols)
+      if (! count || table [probe (symbol, hash_symbol (symbol))].atom == UNDEFINED)
+        f (symbol, atom);
+    for (const auto& e : table)
+      if (e.atom != UNDEFINED)
+        f (std::string_view (e.symbol), e.atom);
+  }
+} outer_dictionary;
+
 // todo: demonstrate initializer merge on dictionaries and vocabularies. needs stronger c++23 implemenation than the one I use just now 
 
-// fancy symbols primitive dumps the symbol->Atom mapping
+// fancy symbols primitive dumps the symbol->Atom mapping, sorted by symbol. frame's words included, they shadow
 void primitive_symbols (class FRAME& frame) {
-  std::cout << "Symbols to Atoms mapping: " << std::endl;
-  for (const auto& [symbol, atom] : outer_dictionary)
-    std::cout << '"' << symbol << '"' << " -> " << atom << std::endl;  
+  std::vector<std::pair<std::string_view, Atom> > symbols;
+  outer_dictionary.for_each ([&] (std::string_view symbol, Atom atom) {
+    if (frame.words.find (symbol) == UNDEFINED) symbols.emplace_back (symbol, atom);
+  });
+  frame.words.for_each ([&symbols] (std::string_view symbol, Atom atom) { symbols.emplace_back (symbol, atom); });
+  std::sort (symbols.begin(), symbols.end());
+
+  frame.output << "Symbols to Atoms mapping: \n";
+  for (const auto& [symbol, atom] : symbols) {
+    frame.output << '"' << symbol << "\" -> ";
+    frame.output.number (atom, 10), frame.output << '\n';
+  }
+}
+
+// profile dump, for hosts and for stats primitive. atoms are named by a symbol bound to them, inner ones by description.
+// most expensive atoms go first
+void dump_profile (const NO_PROFILE& profile, OUTPUT& out) {
+  out << "Profiling is not compiled in, build with FT_PROFILE defined\n";
 }
 
+void dump_profile (const PROFILE& profile, OUTPUT& out) {
+  std::array<std::string_view, ATOMSPACE> names {};
+  outer_dictionary.for_each ([&names] (std::string_view symbol, Atom atom) {
+    if (names [atom].empty() || symbol.size() > names [atom].size()) names [atom] = symbol; // longer is more descriptive
+  });
+  constexpr std::pair<Atom, std::string_view> inner [] {
+    { LITERAL, "(literal)" }, { PLUS_LITERAL, "(plus literal)" },
+    { DUP_DUP, "(dup dup)" }, { OVER_OVER, "(over over)" }, { SWAP_DROP, "(swap drop)" },
+  };
+  for (auto const& [atom, name] : inner) names [atom] = name;
+
+  std::vector<int> atoms;
+  for (std::size_t atom = 0; atom < ATOMSPACE; ++atom)
+    if (profile.calls [atom]) atoms.push_back (atom);
+  std::sort (atoms.begin(), atoms.end(), [&profile] (int a, int b) { return profile.nanoseconds [a] > profile.nanoseconds [b]; });
+
+  auto const count = [&out] (std::uint64_t n) { out << std::string_view (std::to_string (n)); };
+  out << "Atom profile: atom, calls, nanoseconds, symbol\n";
+  for (auto const atom : atoms) {
+    out << "  ", out.number (atom, 10), out << ' ';
+    count (profile.calls [atom]), out << ' ', count (profile.nanoseconds [atom]);
+    out << " \"" << names [atom] << "\"\n";
+  }
+  out << "Undefined symbols: ", count (profile.undefined), out << '\n';
+  out << "Underflows: ", count (profile.underflows), out << '\n';
+}
+
+void primitive_stats (class FRAME& frame) { dump_profile (frame.profile, frame.output); }
+
+void primitive_stats_reset (class FRAME& frame) { frame.profile.reset(); }
+
 // core symbolic language mechanics, this one is "simplest as possible": a mere sequence of symbols
 // even aliens and exotic monsters would understand that
 
-// tokenizer. cuts a 'program' or 'line' string into tokens, usually delimited by spaces of the locale
+// tokenizer. cuts a 'program' or 'line' string into tokens, delimited by white space
 // this is useful for both input preprocessing or programatic preprocessing
-std::list<std::string>& tokenize (const std::string& s) {
-  static std::list<std::string> tokens; // future definitors may need access to tokens following them
-  std::istringstream iss(s); std::string word;
-
-  tokens.clear();
-  while (iss >> std::skipws >> word)
-    tokens.push_back(word);
-  return tokens;
-}
-
-// alternative numeral handler. beware its correctness depends on proper interpret logic,
-// for it may shadow symbols beginning with a digit
-inline bool as_numeral(class FRAME& frame, const std::string& s) {
-  if (s.size() && isdigit(s[0]) ) {
-    std::istringstream iss(s); int n;
-    
-    iss >> std::setbase(frame.base) >> n;
+// tokens are views into the line, nothing is copied or allocated. the line must outlive its tokens.
+// tokenizing is lazy and tokens form a forward range, so future definitors may walk the tokens following them
+constexpr bool is_delimiter (char const c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+class TOKENS {
+  std::string_view text;
+
+public:
+  class iterator {
+    std::string_view token, rest; // empty token with no data marks the end
+
+    void advance (void) {
+      std::size_t i = 0, n = rest.size();
+      while (i < n && is_delimiter (rest [i])) ++i;
+      if (i == n) { token = {}, rest = {}; return; }
+      auto j = i;
+      while (j < n && ! is_delimiter (rest [j])) ++j;
+      token = rest.substr (i, j - i), rest.remove_prefix (j);
+    }
+
+  public:
+    typedef std::string_view value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::forward_iterator_tag iterator_category;
+
+    iterator () = default;
+    explicit iterator (std::string_view const text) : rest (text) { advance(); }
+
+    std::string_view operator* () const { return token; }
+    iterator& operator++ () { advance(); return *this; }
+    iterator operator++ (int) { auto i = *this; advance(); return i; }
+    bool operator== (const iterator& other) const { return token.data() == other.token.data(); }
+  };
+
+  explicit TOKENS (std::string_view const text) : text (text) {}
+
+  iterator begin (void) const { return iterator (text); }
+  iterator end (void) const { return iterator (); }
+};
+
+inline TOKENS tokenize (std::string_view const s) { return TOKENS (s); }
+
+// numeral parser. whole token must be a numeral in base, or it is not one. beware its correctness depends on
+// proper interpret logic, for numerals may shadow symbols: dictionary is asked first, so "dec" stays a symbol in hex.
+// decimal numerals are signed ints. octal and hexadecimal ones are the bits, up to 32 of them, optionally negated,
+// so they read back what DOT shows
+inline bool parse_numeral (std::string_view const s, int const base, int& n) {
+  auto first = s.data(), last = s.data() + s.size();
+  if (base == 10) {
+    auto const [end, error] = std::from_chars (first, last, n);
+    return error == std::errc() && end == last;
+  }
+  bool const negative = s.size() > 1 && *first == '-';
+  std::uint32_t bits;
+  auto const [end, error] = std::from_chars (first + negative, last, bits, base);
+  if (error != std::errc() || end != last) return false;
+  n = int (negative ? 0u - bits : bits);
+  return true;
+}
+
+// alternative numeral handler, pushes the numeral on frame's data stack
+inline bool as_numeral(class FRAME& frame, std::string_view const s) {
+  int n;
+  if (parse_numeral (s, frame.base, n)) {
     frame.data_stack.push(n);
     return true;
   }
   return false;
 }
 
-// list of symbols is interpreted by outer dictionary, programatic only 
-void interpret (std::list<std::string>& symbols) {
-  std::for_each (symbols.begin(), symbols.end(), [](const std::string s) {
-    if ( outer_dictionary.contains(s)) { // if symbol is defined, interpret it
-      execute_primitive ( outer_dictionary [ s ] );
+// symbols resolve to frame's words first, then by outer dictionary
+inline Atom resolve (const WORDS& words, std::string_view const s) {
+  auto const word = words.find (s);
+  return word != UNDEFINED ? word : outer_dictionary.find (s);
+}
+
+// translation depends on numeric base, for numerals. we follow base changes made by the line itself,
+// which are statically known because there is no flow control. composites are inlined as their flat bodies,
+// then the whole program goes through optimizer
+inline int base_after (int const atom, int const base) {
+  switch (atom) {
+  case HEX: return 16;
+  case DEC: return 10;
+  case OCT: return 8;
+  default:  return base;
+  }
+}
+
+// words of a frame are inlined just like composites, so programs compiled against them are valid for that frame only
+PROGRAM compile (TOKENS const symbols, int base, const WORDS& words = no_words) {
+  PROGRAM program;
+
+  for (auto const s : symbols) {
+    if (auto const atom = resolve (words, s); atom != UNDEFINED) {
+      if (! is_composite (atom) && ! is_word (atom)) {
+        program.code.push_back (atom), base = base_after (atom, base);
+        program.defines |= atom == DEFINE;
+        continue;
+      }
+      std::span<const int> const body = is_word (atom) ? words.body (atom) : composites_vocabulary [atom].code;
+      for (std::size_t i = 0; i < body.size(); i += 1 + operands_of (body [i]))
+        base = base_after (body [i], base);
+      program.code.insert (program.code.end(), body.begin(), body.end());
+      continue;
+    }
+    int n;
+    if (parse_numeral (s, base, n)) {
+      program.code.push_back (LITERAL), program.code.push_back (n);
+      continue;
+    }
+    program.code.push_back (UNRESOLVED), program.code.push_back (program.unresolved.size());
+    program.unresolved.emplace_back (s);
+  }
+  optimize (program);
+  program.proof = verify (program.code), program.instructions = instructions (program.code);
+  return program;
+}
+
+// definitor. ": name symbols... ;" compiles symbols in current base and binds the flat body to name, as frame's word.
+// it walks the tokens following it and returns the last one it consumed. a faulty definition defines nothing and
+// consumes all of itself, nested definitions up to the matching ; included, so none of it runs
+TOKENS::iterator define_word (class FRAME& frame, TOKENS::iterator s, TOKENS::iterator const end) {
+  if (++s == end || *s == ";" || *s == ":") {
+    std::cerr << "Warning: definitor expects a name\n";
+    return s;
+  }
+  auto const name = *s, first = ++s == end ? std::string_view() : *s;
+  for (int depth = 0; s != end; ++s) // a nested definitor ends at its own ;, the rejected definition at its matching one
+    if (*s == ":") ++depth;
+    else if (*s == ";" && depth-- == 0) break;
+  if (s == end) {
+    std::cerr << "Warning: definition of " << '"' << name << "\" misses its ;\n";
+    return s;
+  }
+  auto const body = compile (tokenize (std::string_view (first.data(), first.empty() ? 0 : (*s).data() - first.data())),
+                             frame.base, frame.words);
+  if (body.defines) {
+    std::cerr << "Warning: definitions do not nest, " << '"' << name << "\" not defined\n";
+    return s;
+  }
+  if (! body.unresolved.empty()) {
+    for (auto const& symbol : body.unresolved) {
+      frame.profile.undefined_symbol();
+      std::cerr << "Warning: undefined symbol " << '"' << symbol << "\"";
+      std::cerr << " in definition of " << '"' << name << "\"\n";
+    }
+    return s;
+  }
+  if (frame.words.define (name, body.code, body.proof) == UNDEFINED)
+    std::cerr << "Warning: no atoms left for words, " << '"' << name << "\" not defined\n";
+  return s;
+}
+
+// definitor needs the tokens, inner execution has none
+void primitive_define (class FRAME& frame) {
+  std::cerr << "Warning: definitor works in outer interpreter only\n";
+}
+
+// sequence of symbols is interpreted by outer dictionary, programatic only 
+void interpret (class FRAME& frame, TOKENS const symbols) {
+  for (auto s = symbols.begin(); s != symbols.end(); ++s) { // iterator is explicit, a definitor may advance it
+    if (! frame.charge (1)) [[unlikely]] return;
+    if (auto const atom = resolve (frame.words, *s); atom != UNDEFINED) { // if symbol is defined, interpret it
+      if (atom == DEFINE) s = define_word (frame, s, symbols.end());
+      else execute_primitive (frame, atom);
     }
     else { // if symbol fails even as numeral, it has no defined meaning, useless
-      if (! as_numeral(frame, s)) 
-	std::cerr << "Warning: undefined symbol " << '"' << s << '"' << std::endl;
+      if (! as_numeral(frame, *s)) {
+        frame.profile.undefined_symbol();
+	std::cerr << "Warning: undefined symbol " << '"' << *s << "\"\n";
+      }
     } // Do not feed exotic beasts with undefined symbols.
-  });  
+  }
+}
+
+// jit tier.
+// optional, compiled in by FT_JIT. programs executed often enough are promoted: lowered to LLVM IR and compiled
+// to native code by LLVM ORC. only proven programs are, so depth is statically known at every atom, relative to
+// the start, and stack cells become SSA values. memory is touched just for cells the program needs from below and
+// for cells it leaves. numerals are constants. output and frame accessors become direct calls of their primitives,
+// with stack cells written back before and read again after when the primitive works on the stack itself.
+// native code does not profile atoms, and it runs only where the proof holds, just like unchecked code does
+std::size_t jit_threshold = 1000; // executions of a cached program before promotion, zero never. FT_JIT_THRESHOLD overrides
+
+// helpers native code calls directly
+void jit_dot (class FRAME& frame, int const n) { frame.output.number (n, frame.base), frame.output << '\n'; }
+int jit_divide (int const a, int const b) { return a / b; } // the way interpreter divides, by zero included
+
+#ifdef FT_JIT
+class JIT {
+  std::unique_ptr<llvm::orc::LLJIT> lljit;
+  std::mutex lock;
+  std::size_t compiled = 0;
+
+  // atoms whose primitives do not touch data stack. cells stay in registers across their calls
+  static constexpr bool stackless (int const atom) {
+    switch (atom) {
+    case UNDEFINED: case HELLO: case HELP: case QUIT: case ABORT: case DEC: case HEX: case OCT:
+    case SYMBOLS: case FUSIONS: case STATS: case STATS_RESET: case DEFINE: case FORGET:
+    case FLAG_SET: case FLAG_RESET:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // stack of SSA values. cells are indexed relative to the top at start, those below it are negative.
+  // a cell not held is in memory. a dirty one is held and differs from memory
+  class CELLS {
+    llvm::IRBuilder<>& builder;
+    llvm::Value* const sp; // top at start
+    int const bottom;
+    struct CELL { llvm::Value* value = nullptr; bool dirty = false; };
+    std::vector<CELL> cells;
+
+    CELL& at (int const i) { return cells [i - bottom]; }
+    llvm::Value* address (int const i) { return builder.CreateInBoundsGEP (builder.getInt32Ty(), sp, builder.getInt32 (i)); }
+
+  public:
+    int top = 0; // depth relative to start
+
+    CELLS (llvm::IRBuilder<>& builder, llvm::Value* const sp, PROOF const& proof)
+      : builder (builder), sp (sp), bottom (-proof.needs), cells (proof.needs + proof.peak) {}
+
+    llvm::Value* get (int const depth) { // depth 0 is the top cell
+      auto& cell = at (top - 1 - depth);
+      if (! cell.value) cell.value = builder.CreateLoad (builder.getInt32Ty(), address (top - 1 - depth));
+      return cell.value;
+    }
+    void set (int const depth, llvm::Value* const value) { at (top - 1 - depth) = { value, true }; }
+    void push (llvm::Value* const value) { ++top, set (0, value); }
+    void pop (void) { at (--top) = {}; }
+
+    // write dirty cells back, with stack pointer, so memory is the stack again
+    void store (llvm::Value* const sp_slot) {
+      for (int i = bottom; i < top; ++i)
+        if (at (i).dirty) builder.CreateStore (at (i).value, address (i)), at (i).dirty = false;
+      builder.CreateStore (address (top), sp_slot);
+    }
+    void forget (void) { std::fill (cells.begin(), cells.end(), CELL()); }
+  };
+
+  static llvm::Value* call (llvm::IRBuilder<>& builder, void const* const function, llvm::FunctionType* const type,
+                            std::initializer_list<llvm::Value*> const arguments) {
+    auto const address = builder.getInt64 (reinterpret_cast<std::uintptr_t> (function));
+    return builder.CreateCall (type, builder.CreateIntToPtr (address, type->getPointerTo()), arguments);
+  }
+
+  // division goes native unless it would trap. then it calls helper, which traps the same way interpreter does
+  static llvm::Value* divide (llvm::IRBuilder<>& builder, llvm::Value* const a, llvm::Value* const b) {
+    auto const i32 = builder.getInt32Ty();
+    auto const trap = builder.CreateOr (builder.CreateICmpEQ (b, builder.getInt32 (0)),
+                                        builder.CreateAnd (builder.CreateICmpEQ (a, builder.getInt32 (INT32_MIN)),
+                                                           builder.CreateICmpEQ (b, builder.getInt32 (-1))));
+    auto const function = builder.GetInsertBlock()->getParent();
+    auto const slow = llvm::BasicBlock::Create (builder.getContext(), "trap", function);
+    auto const fast = llvm::BasicBlock::Create (builder.getContext(), "divide", function);
+    auto const done = llvm::BasicBlock::Create (builder.getContext(), "divided", function);
+    builder.CreateCondBr (trap, slow, fast);
+    builder.SetInsertPoint (slow);
+    auto const trapped = call (builder, reinterpret_cast<void const*> (jit_divide), llvm::FunctionType::get (i32, { i32, i32 }, false), { a, b });
+    builder.CreateBr (done);
+    builder.SetInsertPoint (fast);
+    auto const quotient = builder.CreateSDiv (a, b);
+    builder.CreateBr (done);
+    builder.SetInsertPoint (done);
+    auto const result = builder.CreatePHI (i32, 2);
+    result->addIncoming (trapped, slow), result->addIncoming (quotient, fast);
+    return result;
+  }
+
+  static bool lower (llvm::Function* const function, const PROGRAM& program) {
+    llvm::IRBuilder<> builder (llvm::BasicBlock::Create (function->getContext(), "entry", function));
+    llvm::Type* const i32 = builder.getInt32Ty(), * const i8p = builder.getInt8PtrTy();
+    auto const frame = function->getArg (0), sp_slot = function->getArg (1);
+    auto const primitive_type = llvm::FunctionType::get (builder.getVoidTy(), { i8p }, false);
+    CELLS cells (builder, builder.CreateLoad (i32->getPointerTo(), sp_slot), program.proof);
+    auto const& code = program.code;
+
+    for (std::size_t i = 0; i < code.size(); ++i) {
+      switch (int const atom = code [i]) {
+      case LITERAL: cells.push (builder.getInt32 (code [++i])); break;
+      case ZERO: case ONE: case TWO: case THREE: cells.push (builder.getInt32 (atom - ZERO)); break;
+      case DROP: cells.pop(); break;
+      case DUP:  cells.push (cells.get (0)); break;
+      case OVER: cells.push (cells.get (1)); break;
+      case SWAP: {
+        auto const a = cells.get (1), b = cells.get (0);
+        cells.set (1, b), cells.set (0, a);
+        break;
+      }
+      case PLUS: case MINUS: case MULT: case DIV: {
+        auto const a = cells.get (1), b = cells.get (0);
+        cells.pop();
+        cells.set (0, atom == PLUS  ? builder.CreateAdd (a, b) : // wrapping, no nsw, as target int arithmetic is
+                      atom == MINUS ? builder.CreateSub (a, b) :
+                      atom == MULT  ? builder.CreateMul (a, b) : divide (builder, a, b));
+        break;
+      }
+      case PLUS_LITERAL: cells.set (0, builder.CreateAdd (cells.get (0), builder.getInt32 (code [++i]))); break;
+      case DUP_DUP: {
+        auto const a = cells.get (0);
+        cells.push (a), cells.push (a);
+        break;
+      }
+      case OVER_OVER: {
+        auto const a = cells.get (1), b = cells.get (0);
+        cells.push (a), cells.push (b);
+        break;
+      }
+      case SWAP_DROP: {
+        auto const b = cells.get (0);
+        cells.pop(), cells.set (0, b);
+        break;
+      }
+      case DOT: {
+        auto const n = cells.get (0);
+        cells.pop();
+        call (builder, reinterpret_cast<void const*> (jit_dot), llvm::FunctionType::get (builder.getVoidTy(), { i8p, i32 }, false), { frame, n });
+        break;
+      }
+      default: { // direct call of primitive bound at the moment of promotion
+        auto const primitive = reinterpret_cast<void const*> (primitives_vocabulary [atom]);
+        if (stackless (atom)) {
+          call (builder, primitive, primitive_type, { frame });
+          break;
+        }
+        cells.store (sp_slot);
+        call (builder, primitive, primitive_type, { frame });
+        cells.forget(), cells.top += effects [atom].out - effects [atom].in;
+      }
+      }
+    }
+    cells.store (sp_slot);
+    builder.CreateRetVoid();
+    return ! llvm::verifyFunction (*function, &llvm::errs());
+  }
+
+public:
+  JIT () {
+    llvm::InitializeNativeTarget(), llvm::InitializeNativeTargetAsmPrinter();
+    auto created = llvm::orc::LLJITBuilder().create();
+    if (! created) {
+      llvm::consumeError (created.takeError());
+      std::cerr << "Warning: jit tier not available, programs stay interpreted\n";
+      return;
+    }
+    lljit = std::move (*created);
+  }
+
+  // native code of a proven program, or nothing
+  NATIVE compile (const PROGRAM& program) {
+    if (! lljit || ! program.proof.known) return nullptr;
+    std::lock_guard<std::mutex> guard (lock);
+    auto const name = "ft_program_" + std::to_string (compiled++);
+    auto context = std::make_unique<llvm::LLVMContext>();
+    auto module = std::make_unique<llvm::Module> (name, *context);
+    auto const i8p = llvm::Type::getInt8PtrTy (*context);
+    auto const type = llvm::FunctionType::get (llvm::Type::getVoidTy (*context),
+                                               { i8p, llvm::Type::getInt32PtrTy (*context)->getPointerTo() }, false);
+    auto const function = llvm::Function::Create (type, llvm::Function::ExternalLinkage, name, module.get());
+    if (! lower (function, program)) return nullptr;
+    if (auto error = lljit->addIRModule (llvm::orc::ThreadSafeModule (std::move (module), std::move (context)))) {
+      llvm::consumeError (std::move (error));
+      return nullptr;
+    }
+    auto symbol = lljit->lookup (name);
+    if (! symbol) {
+      llvm::consumeError (symbol.takeError());
+      return nullptr;
+    }
+    return reinterpret_cast<NATIVE> (symbol->getAddress());
+  }
+};
+
+// one jit for the process, made when first program is promoted. native code lives as long as it does
+NATIVE jit_compile (const PROGRAM& program) {
+  static JIT jit;
+  return jit.compile (program);
+}
+#else
+NATIVE jit_compile (const PROGRAM&) { return nullptr; }
+#endif
+
+// cache of compiled programs, keyed by their source text, numeric base and epoch of words they were compiled against.
+// least recently used programs are forgotten when capacity is exhausted
+class PROGRAM_CACHE {
+  typedef std::list<std::pair<std::string, PROGRAM> > ENTRIES;
+
+  std::size_t capacity;
+  ENTRIES entries; // most recently used first
+  std::unordered_map<std::string_view, ENTRIES::iterator> index; // views into keys owned by entries
+  std::string key; // scratch key, reused to avoid allocation on hits
+
+public:
+  explicit PROGRAM_CACHE (std::size_t capacity = 1024) : capacity (capacity ? capacity : 1) {}
+
+  PROGRAM& operator() (std::string_view const line, int const base, const WORDS& words = no_words) {
+    auto const epoch = words.epoch();
+    key.assign (1, char (base)); // base is tiny, one leading character does
+    key.append (reinterpret_cast<const char*> (&epoch), sizeof epoch).append (line);
+
+    auto found = index.find (key);
+    if (found != index.end()) {
+      entries.splice (entries.begin(), entries, found->second); // touch
+      return found->second->second;
+    }
+    if (entries.size() >= capacity) { // forget least recently used
+      index.erase (entries.back().first);
+      entries.pop_back();
+    }
+    entries.emplace_front (key, compile (tokenize (line), base, words));
+    index.emplace (entries.front().first, entries.begin());
+    return entries.front().second;
+  }
+
+  void clear (void) { index.clear(), entries.clear(); }
+};
+
+thread_local PROGRAM_CACHE program_cache; // shared by line oriented callers of a thread
+
+// interpret one line through the cache. repeated lines skip symbolic resolution entirely, except definitions.
+// cached programs belong to the thread, so it counts their runs and promotes hot ones to native code.
+// a line is the unit of budgets, its status is the result
+STATUS interpret_line (class FRAME& frame, std::string_view const line) {
+  auto& program = program_cache (line, frame.base, frame.words);
+  if (program.defines) interpret (frame, tokenize (line));
+  else {
+    if (jitting && ++program.runs == jit_threshold) program.native = jit_compile (program);
+    execute_program (frame, program);
+  }
+  return frame.settle();
+}
+
+// scheduler.
+// a host may run thousands of frames, one per controlled device say, and feed them batches of jobs: a program against a frame.
+// jobs of one frame run in batch order on one worker, jobs of distinct frames run in parallel on a pool of threads.
+// every frame has a home worker it returns to batch after batch, so its stack stays hot in one core's cache.
+// idle workers steal whole frames from busy ones, and a stolen frame is rehomed to its thief.
+// programs and vocabularies are shared read only while a batch runs. dictionary must not change meanwhile.
+// a batch is the unit of budgets of its frames: every job gets the status of its frame after it, and frames are
+// settled when their jobs are done. frames are tenants, not owners of the host, so the scheduler confines them
+class SCHEDULER {
+public:
+  struct JOB { class FRAME* frame; const PROGRAM* program; };
+
+private:
+  struct TASK { class FRAME* frame; std::vector<std::pair<const PROGRAM*, std::size_t> > programs; unsigned worker; };
+  struct WORKER { std::mutex lock; std::deque<TASK*> tasks; std::thread thread; };
+
+  std::vector<std::unique_ptr<WORKER> > workers;
+  std::unordered_map<class FRAME*, unsigned> homes; // touched by batch submitter only
+  unsigned next_home = 0;
+
+  std::mutex lock; std::condition_variable wakeup, done;
+  std::atomic<std::size_t> queued = 0; // tasks waiting in deques
+  std::size_t pending = 0; // tasks of current batch not finished yet, guarded by lock
+  bool stopping = false; // guarded by lock
+  std::vector<STATUS> statuses; // of current batch, by job. every one is written by the worker of its frame
+
+  // own deque is served from front, in submission order. victims are robbed from back
+  TASK* take (unsigned const self) {
+    for (std::size_t k = 0; k < workers.size(); ++k) {
+      auto& worker = *workers [(self + k) % workers.size()];
+      std::lock_guard<std::mutex> guard (worker.lock);
+      if (worker.tasks.empty()) continue;
+      TASK* task;
+      if (k == 0) task = worker.tasks.front(), worker.tasks.pop_front();
+      else task = worker.tasks.back(), worker.tasks.pop_back();
+      --queued, task->worker = self;
+      return task;
+    }
+    return nullptr;
+  }
+
+  static void pin (unsigned const self) { // worker stays on one core, so do its frames. best effort
+#ifdef __linux__
+    cpu_set_t cpus; CPU_ZERO (&cpus);
+    CPU_SET (self % std::max (1u, std::thread::hardware_concurrency()), &cpus);
+    pthread_setaffinity_np (pthread_self(), sizeof cpus, &cpus);
+#endif
+  }
+
+  void work (unsigned const self) {
+    pin (self);
+    for (;;) {
+      if (auto const task = take (self)) {
+        for (auto const& [program, job] : task->programs) {
+          execute_program (*task->frame, *program);
+          statuses [job] = task->frame->check();
+        }
+        task->frame->settle();
+        std::lock_guard<std::mutex> guard (lock);
+        if (--pending == 0) done.notify_all();
+        continue;
+      }
+      std::unique_lock<std::mutex> guard (lock);
+      wakeup.wait (guard, [this] { return stopping || queued; });
+      if (stopping) return;
+    }
+  }
+
+public:
+  explicit SCHEDULER (unsigned threads = std::thread::hardware_concurrency()) {
+    threads = std::max (1u, threads);
+    for (unsigned i = 0; i < threads; ++i)
+      workers.push_back (std::make_unique<WORKER>());
+    for (unsigned i = 0; i < threads; ++i)
+      workers [i]->thread = std::thread (&SCHEDULER::work, this, i);
+  }
+
+  ~SCHEDULER () {
+    { std::lock_guard<std::mutex> guard (lock); stopping = true; }
+    wakeup.notify_all();
+    for (auto& worker : workers) worker->thread.join();
+  }
+
+  SCHEDULER (const SCHEDULER&) = delete;
+  SCHEDULER& operator= (const SCHEDULER&) = delete;
+
+  unsigned size (void) const { return workers.size(); }
+
+  // run a batch and wait for it. a frame may appear in many jobs, they are executed in order given.
+  // result is status of every job
+  std::vector<STATUS> run (std::span<const JOB> const batch) {
+    std::vector<TASK> tasks;
+    std::unordered_map<class FRAME*, std::size_t> index;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      auto const& job = batch [i];
+      auto const [task, fresh] = index.try_emplace (job.frame, tasks.size());
+      if (fresh) {
+        auto const [home, homeless] = homes.try_emplace (job.frame, next_home);
+        if (homeless) next_home = (next_home + 1) % workers.size();
+        tasks.push_back (TASK { job.frame, {}, home->second });
+        job.frame->confined = true;
+      }
+      tasks [task->second].programs.emplace_back (job.program, i);
+    }
+    statuses.assign (batch.size(), FRAME_OK);
+    if (tasks.empty()) return std::move (statuses);
+
+    { std::lock_guard<std::mutex> guard (lock); pending = tasks.size(), queued += tasks.size(); }
+    for (auto& task : tasks) {
+      std::lock_guard<std::mutex> guard (workers [task.worker]->lock);
+      workers [task.worker]->tasks.push_back (&task);
+    }
+    wakeup.notify_all();
+
+    std::unique_lock<std::mutex> guard (lock);
+    done.wait (guard, [this] { return pending == 0; });
+    for (auto const& task : tasks) homes [task.frame] = task.worker; // thieves keep what they stole
+    return std::move (statuses);
+  }
+
+  // frame leaving the host should be forgotten, its address may be reused
+  void forget (class FRAME& frame) { homes.erase (&frame); }
+};
+
+// lane frames.
+// same short program is often run against many frames differing only in their stack contents. such frames may be
+// bundled as lanes of one structure-of-arrays frame: each stack row holds a cell of every lane, so arithmetic and
+// stack atoms work on all lanes at once, by AVX2 kernels when compiled for it, by scalar loops otherwise.
+// lanes share stack depth. a lane loaded from a shallower frame owns only rows above its bottom, rows below are zeros.
+// when an atom reaches below a lane's bottom, lane underflows just as its scalar frame would, zero enforcement included.
+// diagnostics are per lane masks instead of warnings. atoms with side effects beyond the stack are not supported in lanes
+template<std::size_t LANES> class LANE_FRAME {
+  static_assert (LANES && LANES % 8 == 0, "lanes come in multiples of 8, the width of AVX2 vectors of int");
+
+public:
+  typedef std::bitset<LANES> MASK;
+  static constexpr std::size_t lanes = LANES, capacity = FRAME_STACK_CAPACITY;
+
+  alignas (32) int rows [capacity][LANES]; // row 0 is the bottom
+  std::size_t depth = 0;
+  std::array<std::size_t, LANES> bottom {}; // rows of a lane below its bottom are not lane's own
+  std::size_t floor = 0; // highest bottom of all lanes. operators reaching no lower than that need no lane checks
+  MASK underflow, overflow, division_by_zero;
+
+  int* row (std::size_t const from_top) { return rows [depth - 1 - from_top]; }
+
+  // lanes are loaded from frames and stored back. lanes with no frame stay empty
+  void load (std::span<const FRAME> const frames) {
+    depth = 0;
+    for (auto const& frame : frames) depth = std::max (depth, frame.data_stack.size());
+    for (std::size_t lane = 0; lane < LANES; ++lane) {
+      auto const size = lane < frames.size() ? frames [lane].data_stack.size() : 0;
+      bottom [lane] = depth - size;
+      for (std::size_t r = 0; r < depth; ++r)
+        rows [r][lane] = r < bottom [lane] ? 0 : frames [lane].data_stack [depth - 1 - r];
+    }
+    floor = *std::max_element (bottom.begin(), bottom.end());
+    underflow.reset(), overflow.reset(), division_by_zero.reset();
+  }
+
+  void store (std::span<FRAME> const frames) const {
+    for (std::size_t lane = 0; lane < LANES && lane < frames.size(); ++lane) {
+      auto& stack = frames [lane].data_stack;
+      stack.clear();
+      for (std::size_t r = bottom [lane]; r < depth; ++r)
+        stack.push (rows [r][lane]);
+    }
+  }
+
+  // operator is about to take n rows. one compare on the fast path.
+  // lanes owning fewer rows underflow, and rows they take become theirs, the zeros. too shallow stack is padded for all
+  void take (std::size_t const n) {
+    if (depth >= floor + n) [[likely]] return;
+    if (depth < n) {
+      auto const missing = n - depth;
+      std::copy_backward (&rows [0][0], &rows [depth][0], &rows [n][0]);
+      std::fill (&rows [0][0], &rows [missing][0], 0);
+      depth = n, underflow.set();
+      bottom.fill (0), floor = 0;
+      return;
+    }
+    lower_bottoms (depth - n);
+  }
+
+  void lower_bottoms (std::size_t const row) {
+    for (std::size_t lane = 0; lane < LANES; ++lane)
+      if (bottom [lane] > row) underflow.set (lane), bottom [lane] = row;
+    floor = *std::max_element (bottom.begin(), bottom.end());
+  }
+
+  // lanes owning nothing below the new top row do not own it either, like scalar frames which have nothing to duplicate
+  void disown_top (void) {
+    for (std::size_t lane = 0; lane < LANES; ++lane)
+      if (bottom [lane] == depth - 1) underflow.set (lane), bottom [lane] = depth;
+    floor = *std::max_element (bottom.begin(), bottom.end());
+  }
+
+  // new top row, to be filled by caller. nullptr on overflow
+  int* push (void) {
+    if (depth == capacity) [[unlikely]] { overflow.set(); return nullptr; }
+    return rows [depth++];
+  }
+};
+
+// lane kernels, over n cells. arithmetic wraps, as int arithmetic on targets does
+enum LANE_OPERATOR { LANE_PLUS, LANE_MINUS, LANE_MULT };
+
+template<LANE_OPERATOR OP> inline void lanes_binary (int* a, const int* b, std::size_t const n) {
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 8 <= n; i += 8) {
+    auto const x = _mm256_load_si256 (reinterpret_cast<const __m256i*> (a + i));
+    auto const y = _mm256_load_si256 (reinterpret_cast<const __m256i*> (b + i));
+    auto const r = OP == LANE_PLUS ? _mm256_add_epi32 (x, y) : OP == LANE_MINUS ? _mm256_sub_epi32 (x, y) : _mm256_mullo_epi32 (x, y);
+    _mm256_store_si256 (reinterpret_cast<__m256i*> (a + i), r);
+  }
+#endif
+  for (; i < n; ++i) {
+    auto const x = unsigned (a [i]), y = unsigned (b [i]);
+    a [i] = int (OP == LANE_PLUS ? x + y : OP == LANE_MINUS ? x - y : x * y);
+  }
+}
+
+inline void lanes_fill (int* a, int const value, std::size_t const n) { std::fill (a, a + n, value); }
+
+inline void lanes_add (int* a, int const value, std::size_t const n) {
+  for (std::size_t i = 0; i < n; ++i) a [i] = int (unsigned (a [i]) + unsigned (value)); // vectorized by compiler
 }
 
+// division truncates toward zero, as in C++. lanes dividing by zero get zero and are reported in mask
+template<std::size_t LANES> inline void lanes_divide (int* a, const int* b, std::bitset<LANES>& by_zero) {
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  // 32 bit ints divide exactly in doubles, truncation is then the same as integer division
+  for (; i + 8 <= LANES; i += 8) {
+    auto const x = _mm256_load_si256 (reinterpret_cast<const __m256i*> (a + i));
+    auto const y = _mm256_load_si256 (reinterpret_cast<const __m256i*> (b + i));
+    auto const zero = _mm256_cmpeq_epi32 (y, _mm256_setzero_si256());
+    auto const divisor = _mm256_blendv_epi8 (y, _mm256_set1_epi32 (1), zero);
+    auto const low = _mm256_cvttpd_epi32 (_mm256_div_pd (_mm256_cvtepi32_pd (_mm256_castsi256_si128 (x)),
+                                                         _mm256_cvtepi32_pd (_mm256_castsi256_si128 (divisor))));
+    auto const high = _mm256_cvttpd_epi32 (_mm256_div_pd (_mm256_cvtepi32_pd (_mm256_extracti128_si256 (x, 1)),
+                                                          _mm256_cvtepi32_pd (_mm256_extracti128_si256 (divisor, 1))));
+    auto const q = _mm256_andnot_si256 (zero, _mm256_inserti128_si256 (_mm256_castsi128_si256 (low), high, 1));
+    _mm256_store_si256 (reinterpret_cast<__m256i*> (a + i), q);
+    for (unsigned m = _mm256_movemask_ps (_mm256_castsi256_ps (zero)); m; m &= m - 1)
+      by_zero.set (i + std::countr_zero (m));
+  }
+#endif
+  for (; i < LANES; ++i) {
+    if (b [i] == 0) { a [i] = 0, by_zero.set (i); continue; }
+    a [i] = b [i] == -1 ? int (0u - unsigned (a [i])) : a [i] / b [i]; // the one overflowing quotient wraps too
+  }
+}
+
+// lane executor. runs a compiled program on all lanes. returns UNDEFINED when done,
+// or the atom it stopped at, before executing it, when that one is not supported in lanes
+template<std::size_t LANES> Atom execute_lanes (LANE_FRAME<LANES>& frame, const PROGRAM& program) {
+  auto const& code = program.code;
+
+  for (std::size_t i = 0; i < code.size(); ++i) {
+    int const atom = code [i];
+    switch (atom) {
+    case ZERO: case ONE: case TWO: case THREE: case LITERAL: case DEPTH:
+      if (auto const top = frame.push()) {
+        if (atom == DEPTH)
+          for (std::size_t lane = 0; lane < LANES; ++lane) top [lane] = frame.depth - 1 - frame.bottom [lane];
+        else lanes_fill (top, atom == LITERAL ? code [i + 1] : atom - ZERO, LANES);
+      }
+      i += operands_of (atom);
+      break;
+    case DROP:
+      if (frame.depth == 0) { frame.underflow.set(); break; }
+      if (frame.depth <= frame.floor) frame.lower_bottoms (frame.depth - 1);
+      --frame.depth;
+      break;
+    case DUP: case DUP_DUP:
+      for (int n = atom == DUP ? 1 : 2; n; --n) {
+        if (frame.depth == 0) { frame.underflow.set(); continue; }
+        bool const owned = frame.depth > frame.floor; // by every lane
+        auto const copy = frame.row (0);
+        if (auto const top = frame.push()) {
+          std::copy (copy, copy + LANES, top);
+          if (! owned) frame.disown_top();
+        }
+      }
+      break;
+    case SWAP:
+      frame.take (2), std::swap_ranges (frame.row (0), frame.row (0) + LANES, frame.row (1));
+      break;
+    case OVER: case OVER_OVER:
+      for (int n = atom == OVER ? 1 : 2; n; --n) {
+        frame.take (2);
+        auto const copy = frame.row (1);
+        if (auto const top = frame.push()) std::copy (copy, copy + LANES, top);
+      }
+      break;
+    case SWAP_DROP:
+      frame.take (2), std::copy (frame.row (0), frame.row (0) + LANES, frame.row (1)), --frame.depth;
+      break;
+    case PLUS:
+      frame.take (2), lanes_binary<LANE_PLUS> (frame.row (1), frame.row (0), LANES), --frame.depth;
+      break;
+    case MINUS:
+      frame.take (2), lanes_binary<LANE_MINUS> (frame.row (1), frame.row (0), LANES), --frame.depth;
+      break;
+    case MULT:
+      frame.take (2), lanes_binary<LANE_MULT> (frame.row (1), frame.row (0), LANES), --frame.depth;
+      break;
+    case DIV:
+      frame.take (2), lanes_divide<LANES> (frame.row (1), frame.row (0), frame.division_by_zero), --frame.depth;
+      break;
+    case PLUS_LITERAL:
+      if (frame.depth == frame.capacity) [[unlikely]] frame.overflow.set(); // no room for its literal, like scalar
+      frame.take (1), lanes_add (frame.row (0), code [++i], LANES);
+      break;
+    case UNDEFINED: case UNRESOLVED: // no operation, warnings are not kept in lanes
+      i += operands_of (atom);
+      break;
+    default:
+      if (is_composite (atom)) { // hand made programs may refer composites, compiled ones have them inlined
+        if (auto const stop = execute_lanes (frame, composites_vocabulary [atom]); stop != UNDEFINED) return stop;
+        break;
+      }
+      return Atom (atom);
+    }
+  }
+  return UNDEFINED;
+}
+
+// snapshots.
+// frame state as a versioned binary image: stack cells, base, flag, and frame's words with their arena.
+// built-in vocabularies are code, not state, so they are not saved. their fingerprint is, so a build whose atoms
+// mean something else refuses the snapshot. image layout, native byte order, every part aligned to four bytes:
+//   header, stack cells from the bottom, word records, arena cells, names
+// restore maps the file and copies those few blocks out of the mapping, so it costs what paging the file in does.
+// a stack deeper than frame's bound does not fit, so quotas are to be set before restoring
+// snapshot files are replaced by rename, so a crash while writing leaves the previous one whole
+constexpr char SNAPSHOT_MAGIC [8] { 'F', 'T', 'S', 'N', 'A', 'P', '\r', '\n' };
+constexpr std::uint32_t SNAPSHOT_VERSION = 1;
+
+constexpr std::uint32_t builtin_fingerprint = [] {
+  auto h = hash_symbol ("", std::uint32_t (STATIC_ATOMS) << 16 ^ std::uint32_t (FIRST_WORD) << 8 ^ std::uint32_t (ATOMSPACE));
+  for (const auto& [symbol, atom] : builtin_symbols)
+    h = hash_symbol (symbol, h ^ std::uint32_t (atom));
+  return h;
+} ();
+
+struct SNAPSHOT_HEADER {
+  char magic [8];
+  std::uint32_t version, fingerprint;
+  std::int32_t base;
+  std::uint32_t flag;
+  std::uint32_t depth, words, cells, names; // stack cells, word records, arena cells, bytes of names
+};
+
+std::string snapshot_image (const FRAME& frame) {
+  std::vector<int> block;
+  std::string names;
+  auto const records = frame.words.records (block, names);
+  SNAPSHOT_HEADER const header {
+    {}, SNAPSHOT_VERSION, builtin_fingerprint, frame.base, frame._FLAG(),
+    std::uint32_t (frame.data_stack.size()), std::uint32_t (records.size()), std::uint32_t (block.size()), std::uint32_t (names.size())
+  };
+  std::string image;
+  image.reserve (sizeof header + 4 * (header.depth + header.cells) + sizeof (WORDS::RECORD) * header.words + names.size());
+  auto const append = [&image] (const void* data, std::size_t size) { image.append (static_cast<const char*> (data), size); };
+  append (&header, sizeof header);
+  std::copy (SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof SNAPSHOT_MAGIC, image.begin());
+  for (auto depth = frame.data_stack.size(); depth--; )
+    append (&frame.data_stack [depth], sizeof (int));
+  append (records.data(), records.size() * sizeof (WORDS::RECORD));
+  append (block.data(), block.size() * sizeof (int));
+  append (names.data(), names.size());
+  return image;
+}
+
+// image goes to a temporary file next to path first, then replaces it
+bool write_snapshot (std::string_view const image, std::string const& path) {
+  auto const temporary = path + ".tmp";
+  int const fd = open (temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+  for (std::size_t done = 0; done < image.size(); ) {
+    auto const n = ::write (fd, image.data() + done, image.size() - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return close (fd), unlink (temporary.c_str()), false;
+    done += n;
+  }
+  bool const synced = fsync (fd) == 0;
+  close (fd);
+  return synced && rename (temporary.c_str(), path.c_str()) == 0;
+}
+
+bool snapshot (const FRAME& frame, std::string const& path) { return write_snapshot (snapshot_image (frame), path); }
+
+// restore replaces frame's stack, base, flag and words. a snapshot not fitting this build changes nothing
+bool restore (FRAME& frame, std::string const& path) {
+  int const fd = open (path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  auto const size = fstat (fd, &st) == 0 ? std::size_t (st.st_size) : 0;
+  auto const map = size >= sizeof (SNAPSHOT_HEADER) ? mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close (fd);
+  if (map == MAP_FAILED) return false;
+  madvise (map, size, MADV_SEQUENTIAL);
+
+  auto const bytes = static_cast<const char*> (map);
+  SNAPSHOT_HEADER header;
+  std::copy (bytes, bytes + sizeof header, reinterpret_cast<char*> (&header));
+  auto const expected = sizeof header + 4 * (std::uint64_t (header.depth) + header.cells)
+                      + sizeof (WORDS::RECORD) * std::uint64_t (header.words) + header.names;
+  bool valid = std::equal (SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof SNAPSHOT_MAGIC, header.magic)
+            && header.version == SNAPSHOT_VERSION && header.fingerprint == builtin_fingerprint
+            && (header.base == 8 || header.base == 10 || header.base == 16)
+            && header.depth <= frame.data_stack.limit() && expected == size;
+  if (valid) {
+    auto const cells = reinterpret_cast<const int*> (bytes + sizeof header); // mapping is page aligned, parts keep four
+    auto const records = reinterpret_cast<const WORDS::RECORD*> (cells + header.depth);
+    auto const block = reinterpret_cast<const int*> (records + header.words);
+    std::string_view const names (reinterpret_cast<const char*> (block + header.cells), header.names);
+    valid = frame.words.adopt ({ records, header.words }, { block, header.cells }, names);
+    if (valid) {
+      frame.data_stack.clear();
+      for (std::uint32_t i = 0; i < header.depth; ++i) frame.data_stack.push_unchecked (cells [i]);
+      frame.base = header.base;
+      if (header.flag) frame._FLAG_SET(); else frame._FLAG_RESET();
+    }
+  }
+  munmap (map, size);
+  return valid;
+}
+
+// checkpoints. host offers its frame between lines, a checkpoint is due when period has passed. only the image is
+// taken right there, which is a copy of stack and arena, writing it is left to a background thread.
+// an image not written yet is superseded by a newer one. clock is read on every offer, a shell may offer one line
+// an hour. reading a monotonic clock costs little next to reading the line
+class CHECKPOINTS {
+  typedef std::chrono::steady_clock clock;
+
+  std::string const path;
+  clock::duration const period;
+  clock::time_point due;
+
+  std::mutex lock;
+  std::condition_variable wake;
+  std::string image; // newest image to write, guarded by lock
+  bool pending = false, stopping = false;
+  std::thread writer;
+
+  void write (void) {
+    std::unique_lock<std::mutex> guard (lock);
+    for (;;) {
+      wake.wait (guard, [this] { return pending || stopping; });
+      if (! pending) return;
+      std::string taken;
+      taken.swap (image), pending = false;
+      guard.unlock();
+      if (! write_snapshot (taken, path)) std::cerr << "Warning: checkpoint to " << '"' << path << "\" failed\n";
+      guard.lock();
+    }
+  }
+
+public:
+  CHECKPOINTS (std::string path, clock::duration const period)
+    : path (std::move (path)), period (period), due (clock::now() + period), writer (&CHECKPOINTS::write, this) {}
+
+  ~CHECKPOINTS () { // writes what is pending
+    { std::lock_guard<std::mutex> guard (lock); stopping = true; }
+    wake.notify_one(), writer.join();
+  }
+
+  void offer (const FRAME& frame) {
+    if (auto const now = clock::now(); now >= due) due = now + period, checkpoint (frame);
+  }
+
+  void checkpoint (const FRAME& frame) {
+    auto taken = snapshot_image (frame);
+    { std::lock_guard<std::mutex> guard (lock); image.swap (taken), pending = true; }
+    wake.notify_one();
+  }
+};
+
 // minimalist shell suitable for user input. partial teletype editing only
 // not impressive but unlike fancy local editing stuff, it's actually useful as remote datalink, as for decades
 // also, AIs don't do typo mistakes, do they? After all, they can always use a backspace.
-void microshell (const std::string& prompt) {
+// shell's own texts go to the buffer directly, so they are not charged to output quota of the lines
+void microshell (class FRAME& frame, const std::string& prompt, CHECKPOINTS* const checkpoints = nullptr) {
   std::string line;  
 
-  while (1) {
-    std::cout << prompt;
-    std::getline(std::cin, line); // beware of terminal navigation keys, they produce platform-specific junk. use backspace
-    interpret (tokenize (line));
+  while (! frame.ended) {
+    frame.output.pending().append (prompt), frame.output.flush(); // output of previous line goes along with the prompt
+    if (! std::getline(std::cin, line)) break; // beware of terminal navigation keys, they produce platform-specific junk. use backspace
+    report_status (interpret_line (frame, line));
+    if (checkpoints) checkpoints->offer (frame);
+  }
+  if (! frame.ended) frame.output.pending().append (1, '\n');
+}
+
+// batch mode. non interactive, no prompts, no banners. suitable for scripts and long command logs in pipes.
+// text is consumed in large pieces and lines are cut out of it in place. frame's output is flushed by threshold only.
+// shells stop where their frame's work ends
+void interpret_lines (class FRAME& frame, std::string_view text, CHECKPOINTS* const checkpoints = nullptr) {
+  while (! text.empty() && ! frame.ended) {
+    auto const eol = std::min (text.find ('\n'), text.size());
+    report_status (interpret_line (frame, text.substr (0, eol)));
+    if (checkpoints) checkpoints->offer (frame);
+    text.remove_prefix (std::min (eol + 1, text.size()));
   }
 }
 
-int main () {
-  std::cout << "Frame Toy, version 0.0" << std::endl;
-  std::cout << "Say 'help' to get help, 'symbols' to list dictionary, 'quit' to terminate." << std::endl;
-  microshell("FT:> ");
+void batch (class FRAME& frame, int const fd, CHECKPOINTS* const checkpoints = nullptr) {
+  struct stat st;
+  if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode) && st.st_size > 0) { // regular files are mapped whole
+    auto const size = std::size_t (st.st_size);
+    auto const map = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      madvise (map, size, MADV_SEQUENTIAL);
+      interpret_lines (frame, std::string_view (static_cast<const char*> (map), size), checkpoints);
+      munmap (map, size);
+      return;
+    }
+  }
+  std::vector<char> chunk (1 << 20); // streams are read in chunks, an incomplete last line is carried over
+  std::size_t kept = 0;
+  while (! frame.ended) {
+    if (kept == chunk.size()) chunk.resize (2 * chunk.size()); // a line longer than chunk
+    auto const n = ::read (fd, chunk.data() + kept, chunk.size() - kept);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    std::string_view const text (chunk.data(), kept + n);
+    auto const eol = text.rfind ('\n');
+    if (eol == std::string_view::npos) { kept = text.size(); continue; }
+    interpret_lines (frame, text.substr (0, eol + 1), checkpoints);
+    kept = text.size() - eol - 1;
+    std::copy (chunk.begin() + eol + 1, chunk.begin() + text.size(), chunk.begin());
+  }
+  interpret_lines (frame, std::string_view (chunk.data(), kept), checkpoints);
+}
+
+// datalink server.
+// microshell serves one user on a terminal. server serves many sessions on a Unix domain socket or TCP loopback,
+// multiplexed by epoll in one thread, every session with a frame of its own. session speaks just like microshell:
+// banner and prompt on connect, then output of every line followed by prompt. clients may pipeline lines, which are
+// interpreted in batches: all that arrived by a wakeup, up to a budget, so busy sessions do not starve others.
+// output is collected in session's frame and sent as fast as its socket takes it. when too much waits, session is
+// neither read nor interpreted until its client takes enough, that's backpressure. warnings go to server's stderr,
+// but a line stopped by quotas of its session is answered by its status
+// address is a path for a Unix domain socket, or a port number for TCP on loopback
+#ifdef __linux__
+class SERVER {
+  static constexpr std::size_t CHUNK = 1 << 16;      // bytes read per session and wakeup
+  static constexpr std::size_t LINES = 256;          // lines interpreted per session and wakeup
+  static constexpr std::size_t HIGH_WATER = 1 << 20; // output waiting, session is throttled above
+  static constexpr std::size_t LOW_WATER = 1 << 16;  // and released below
+  static constexpr std::string_view prompt = "FT:> ";
+
+  struct SESSION {
+    FRAME frame;
+    std::string input; // received and not interpreted yet. an incomplete last line stays here
+    std::uint32_t events = 0; // registered with epoll
+    bool eof = false, throttled = false, backlogged = false;
+    bool overlong = false; // rest of a line too long is being skipped
+
+    std::string& output (void) { return frame.output.pending(); }
+    bool lines (void) const { return input.find ('\n') != std::string::npos || (eof && ! input.empty()); }
+    bool finished (void) { return (frame.ended || (eof && input.empty())) && output().empty(); }
+  };
+
+  int listener = -1, poller = -1;
+  std::string path; // of Unix domain socket, removed when done
+  std::vector<std::unique_ptr<SESSION> > sessions; // indexed by socket
+  std::vector<int> backlog; // sessions left with complete lines by budget
+  bool accepting = true; // listener is watched. out of descriptors, it is not until some session ends
+
+  void listen_to (bool const on) {
+    epoll_event e { on ? std::uint32_t (EPOLLIN) : 0, { .fd = listener } };
+    epoll_ctl (poller, EPOLL_CTL_MOD, listener, &e), accepting = on;
+  }
+
+  void end (int const fd) {
+    sessions [fd].reset();
+    close (fd); // epoll forgets it by itself
+    if (! accepting) listen_to (true);
+  }
+
+  // session wants input unless it is done or throttled, and output while any waits
+  void watch (int const fd, SESSION& s) {
+    std::uint32_t events = 0;
+    if (! s.eof && ! s.frame.ended && ! s.throttled && s.input.size() < HIGH_WATER) events |= EPOLLIN;
+    if (! s.output().empty()) events |= EPOLLOUT;
+    if (events == s.events) return;
+    epoll_event e { events, { .fd = fd } };
+    epoll_ctl (poller, EPOLL_CTL_MOD, fd, &e), s.events = events;
+  }
+
+  bool receive (int const fd, SESSION& s) {
+    auto const kept = s.input.size();
+    s.input.resize (kept + CHUNK);
+    auto const n = recv (fd, s.input.data() + kept, CHUNK, 0);
+    s.input.resize (kept + std::max<ssize_t> (n, 0));
+    if (n == 0) s.eof = true;
+    return n >= 0 || errno == EAGAIN || errno == EINTR;
+  }
+
+  bool transmit (int const fd, SESSION& s) {
+    auto& out = s.output();
+    std::size_t sent = 0;
+    while (sent < out.size()) {
+      auto const n = send (fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+      if (n > 0) { sent += n; continue; }
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0 && errno == EAGAIN) break;
+      return false;
+    }
+    out.erase (0, sent);
+    if (s.throttled && out.size() < LOW_WATER) s.throttled = false;
+    return true;
+  }
+
+  // a batch of lines, each answered by prompt. a line longer than high watermark would never be complete,
+  // for it is not read further. it is answered by an error and skipped up to its end
+  void interpret (int const fd, SESSION& s) {
+    if (s.overlong) {
+      auto const eol = s.input.find ('\n');
+      s.input.erase (0, eol == std::string::npos ? eol : eol + 1), s.overlong = eol == std::string::npos;
+    }
+    std::size_t done = 0;
+    for (std::size_t lines = 0; lines < LINES && ! s.frame.ended && ! s.throttled; ++lines) {
+      auto eol = s.input.find ('\n', done);
+      if (eol == std::string::npos) {
+        if (! s.eof || done == s.input.size()) break;
+        eol = s.input.size(); // last line without end
+      }
+      auto const status = interpret_line (s.frame, std::string_view (s.input).substr (done, eol - done));
+      if (failed (status)) [[unlikely]] s.output().append ("Error: ").append (status_messages [status]).append ("\n");
+      s.output().append (prompt);
+      done = std::min (eol + 1, s.input.size());
+      s.throttled = s.output().size() >= HIGH_WATER;
+    }
+    s.input.erase (0, done);
+    if (s.input.size() >= HIGH_WATER && s.input.find ('\n') == std::string::npos) [[unlikely]] {
+      s.output().append ("Error: line too long\n").append (prompt);
+      s.input.clear(), s.overlong = true;
+    }
+    if (s.frame.ended) s.input.clear();
+    if (! s.frame.ended && ! s.throttled && s.lines() && ! s.backlogged) backlog.push_back (fd), s.backlogged = true;
+  }
+
+  void step (int const fd, SESSION& s) {
+    interpret (fd, s);
+    if (! transmit (fd, s) || s.finished()) return end (fd);
+    watch (fd, s);
+  }
+
+  void accept_all (void) {
+    for (;;) {
+      int const fd = accept4 (listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+        // out of descriptors, listener would stay readable. those waiting stay queued until some session ends
+        if (errno != EAGAIN) listen_to (false);
+        return;
+      }
+      if (path.empty()) { int const on = 1; setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on); }
+      if (std::size_t (fd) >= sessions.size()) sessions.resize (fd + 1);
+      auto& s = *(sessions [fd] = std::make_unique<SESSION>());
+      s.frame.confined = true, s.frame.output.sink = -1; // server collects output itself
+      s.frame.limit (quotas);
+      s.output().append ("Frame Toy, version 0.0\n").append (prompt);
+      epoll_event e { s.events = EPOLLIN | EPOLLOUT, { .fd = fd } };
+      epoll_ctl (poller, EPOLL_CTL_ADD, fd, &e);
+    }
+  }
+
+public:
+  QUOTAS quotas; // of every session
+
+  ~SERVER () {
+    for (std::size_t fd = 0; fd < sessions.size(); ++fd)
+      if (sessions [fd]) end (fd);
+    if (listener >= 0) close (listener);
+    if (poller >= 0) close (poller);
+    if (! path.empty()) unlink (path.c_str());
+  }
+
+  bool listen (std::string const& address) {
+    rlimit limit; // thousands of sessions need as many descriptors as allowed
+    if (getrlimit (RLIMIT_NOFILE, &limit) == 0) limit.rlim_cur = limit.rlim_max, setrlimit (RLIMIT_NOFILE, &limit);
+
+    if (address.find ('/') != std::string::npos) {
+      sockaddr_un local { AF_UNIX, {} };
+      if (address.size() >= sizeof local.sun_path) return false;
+      std::copy (address.begin(), address.end(), local.sun_path);
+      listener = socket (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      unlink (address.c_str()); // stale socket of a previous server
+      if (listener < 0 || bind (listener, reinterpret_cast<sockaddr*> (&local), sizeof local) < 0) return false;
+      path = address;
+    }
+    else {
+      std::uint16_t port = 0;
+      auto const [end, error] = std::from_chars (address.data(), address.data() + address.size(), port);
+      if (error != std::errc() || end != address.data() + address.size()) return false;
+      sockaddr_in loopback { AF_INET, htons (port), { htonl (INADDR_LOOPBACK) }, {} };
+      listener = socket (AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      int const on = 1;
+      if (listener < 0 || setsockopt (listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) < 0
+          || bind (listener, reinterpret_cast<sockaddr*> (&loopback), sizeof loopback) < 0) return false;
+    }
+    poller = epoll_create1 (EPOLL_CLOEXEC);
+    epoll_event e { EPOLLIN, { .fd = listener } };
+    return ::listen (listener, SOMAXCONN) == 0 && poller >= 0 && epoll_ctl (poller, EPOLL_CTL_ADD, listener, &e) == 0;
+  }
+
+  // serve forever. sessions left with lines by budget are served again right after other events
+  void run (void) {
+    std::vector<epoll_event> events (1024);
+    for (;;) {
+      int const n = epoll_wait (poller, events.data(), events.size(), backlog.empty() ? -1 : 0);
+      if (n < 0 && errno != EINTR) return;
+      for (int i = 0; i < n; ++i) {
+        int const fd = events [i].data.fd;
+        if (fd == listener) { accept_all(); continue; }
+        if (std::size_t (fd) >= sessions.size() || ! sessions [fd]) continue; // ended meanwhile
+        auto& s = *sessions [fd];
+        if (events [i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) && ! receive (fd, s)) { end (fd); continue; }
+        step (fd, s);
+      }
+      std::vector<int> again;
+      again.swap (backlog);
+      for (int const fd : again)
+        if (std::size_t (fd) < sessions.size() && sessions [fd])
+          sessions [fd]->backlogged = false, step (fd, *sessions [fd]);
+    }
+  }
+};
+#endif
+
+// with no arguments, we are interactive. arguments are scripts to run in batch mode, '-' stands for standard input
+// with FT_SNAPSHOT naming a file, frame starts from snapshot there if there is one, and it is checkpointed there
+// every FT_CHECKPOINT seconds, 60 by default, and when input ends
+// "--serve address" runs datalink server instead. FT_QUOTA_ATOMS, FT_QUOTA_DEPTH and FT_QUOTA_OUTPUT set quotas per line
+// programs embedding the toy (benchmarks, for one) bring their own main
+#ifndef FT_EMBEDDED
+int main (int argc, char* argv []) {
+  FRAME frame; // console's own frame. confined, so quit and exit come back here and the last checkpoint is taken
+  frame.confined = true;
+  if (auto const threshold = std::getenv ("FT_JIT_THRESHOLD")) jit_threshold = std::strtoull (threshold, nullptr, 10);
+  QUOTAS quotas;
+  for (auto [name, quota] : { std::pair { "FT_QUOTA_ATOMS", &quotas.atoms }, { "FT_QUOTA_DEPTH", &quotas.depth },
+                              { "FT_QUOTA_OUTPUT", &quotas.output } })
+    if (auto const value = std::getenv (name)) *quota = std::strtoull (value, nullptr, 10);
+  frame.limit (quotas);
+
+#ifdef __linux__
+  if (argc == 3 && std::string_view (argv [1]) == "--serve") {
+    SERVER server;
+    server.quotas = quotas;
+    if (! server.listen (argv [2])) {
+      std::cerr << "Error: cannot listen on " << '"' << argv [2] << "\"\n";
+      return 1;
+    }
+    server.run();
+    return 1;
+  }
+#endif
+
+  std::unique_ptr<CHECKPOINTS> checkpoints;
+  if (auto const path = std::getenv ("FT_SNAPSHOT")) {
+    if (! restore (frame, path) && access (path, F_OK) == 0) // someone else's, perhaps. leave it be
+      std::cerr << "Warning: snapshot " << '"' << path << "\" does not fit this frame, not restored nor checkpointed\n";
+    else {
+      auto const seconds = std::getenv ("FT_CHECKPOINT");
+      checkpoints = std::make_unique<CHECKPOINTS> (path, std::chrono::seconds (seconds ? std::strtoull (seconds, nullptr, 10) : 60));
+    }
+  }
+
+  if (argc > 1) {
+    for (int i = 1; i < argc && ! frame.ended; ++i) {
+      std::string_view const name (argv [i]);
+      int const fd = name == "-" ? STDIN_FILENO : open (argv [i], O_RDONLY);
+      if (fd < 0) {
+        std::cerr << "Error: cannot open script " << '"' << name << "\"\n";
+        continue;
+      }
+      batch (frame, fd, checkpoints.get());
+      if (fd != STDIN_FILENO) close (fd);
+    }
+  }
+  else {
+    frame.output.pending().append ("Frame Toy, version 0.0\n")
+                            .append ("Say 'help' to get help, 'symbols' to list dictionary, 'quit' to terminate.\n");
+    microshell(frame, "FT:> ", checkpoints.get());
+  }
+  if (frame.aborted) frame.output.flush(), abort(); // a trap, state is not worth keeping
+  if (checkpoints) checkpoints->checkpoint (frame);
+  return frame.exit_code;
 }
+#endif
 
  /*
    
@@ -0,0 +1,123 @@
+// Load generator for the datalink server of Frame Toy
+
+// Opens many sessions to a server and keeps every one busy with a pipeline of commands. A command is one line,
+// its response ends with prompt, so latency of a command is from sending its line to receiving its prompt.
+// With no address, the toy is embedded and its server runs in a thread of its own on a private Unix domain socket.
+// Result is a JSON line on standard output: throughput and p50/p99 latency of commands.
+// Usage: ftload [address|-] [sessions] [commands per session] [pipeline depth]
+
+#define FT_EMBEDDED
+#include "ft.cpp"
+
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <cstdlib>
+#include <unistd.h>
+
+using clock_type = std::chrono::steady_clock;
+
+struct CLIENT {
+  int fd = -1;
+  bool greeted = false;                 // banner and first prompt arrived
+  std::size_t sent = 0, answered = 0;   // commands
+  std::deque<clock_type::time_point> in_flight;
+  std::string tail;                     // end of received data, prompt may be split across reads
+  std::string out;                      // lines not sent yet
+};
+
+int connect_to (std::string const& address) {
+  if (address.find ('/') != std::string::npos) {
+    sockaddr_un local { AF_UNIX, {} };
+    if (address.size() >= sizeof local.sun_path) return -1;
+    std::copy (address.begin(), address.end(), local.sun_path);
+    int const fd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connect (fd, reinterpret_cast<sockaddr*> (&local), sizeof local) == 0) return fd;
+    close (fd);
+    return -1;
+  }
+  sockaddr_in loopback { AF_INET, htons (std::atoi (address.c_str())), { htonl (INADDR_LOOPBACK) }, {} };
+  int const fd = socket (AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0), on = 1;
+  setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+  if (connect (fd, reinterpret_cast<sockaddr*> (&loopback), sizeof loopback) == 0) return fd;
+  close (fd);
+  return -1;
+}
+
+int main (int argc, char* argv []) {
+  std::string address = argc > 1 ? argv [1] : "-";
+  std::size_t const sessions = argc > 2 ? std::strtoull (argv [2], nullptr, 10) : 100;
+  std::size_t const commands = argc > 3 ? std::strtoull (argv [3], nullptr, 10) : 1000;
+  std::size_t const pipeline = std::max<std::size_t> (argc > 4 ? std::strtoull (argv [4], nullptr, 10) : 8, 1);
+  std::string_view constexpr command = "1 2 + .\n", prompt = "FT:> ";
+  if (sessions == 0 || commands == 0) { std::cerr << "Error: sessions and commands must be positive\n"; return 1; }
+
+  if (address == "-") {
+    address = "/tmp/ftload." + std::to_string (getpid());
+    auto server = new SERVER; // lives as long as the process
+    if (! server->listen (address)) { std::cerr << "Error: cannot listen on " << address << "\n"; return 1; }
+    std::thread ([server] { server->run(); }).detach();
+  }
+
+  rlimit limit;
+  if (getrlimit (RLIMIT_NOFILE, &limit) == 0) limit.rlim_cur = limit.rlim_max, setrlimit (RLIMIT_NOFILE, &limit);
+
+  int const poller = epoll_create1 (EPOLL_CLOEXEC);
+  std::vector<CLIENT> clients (sessions);
+  for (auto& c : clients) {
+    if ((c.fd = connect_to (address)) < 0) { std::cerr << "Error: cannot connect to " << address << "\n"; return 1; }
+    fcntl (c.fd, F_SETFL, O_NONBLOCK);
+    epoll_event e { EPOLLIN, { .ptr = &c } };
+    epoll_ctl (poller, EPOLL_CTL_ADD, c.fd, &e);
+  }
+
+  std::vector<std::uint32_t> latencies; // ns
+  latencies.reserve (sessions * commands);
+  std::size_t done = 0;
+  std::vector<epoll_event> events (1024);
+  char buffer [1 << 16];
+  auto const start = clock_type::now();
+
+  while (done < sessions) {
+    int const n = epoll_wait (poller, events.data(), events.size(), -1);
+    for (int i = 0; i < n; ++i) {
+      auto& c = *static_cast<CLIENT*> (events [i].data.ptr);
+      if (events [i].events & EPOLLIN) {
+        auto const got = recv (c.fd, buffer, sizeof buffer, 0);
+        if (got <= 0) { std::cerr << "Error: server closed a session\n"; return 1; }
+        auto const now = clock_type::now();
+        c.tail.append (buffer, got);
+        for (std::size_t at; (at = c.tail.find (prompt)) != std::string::npos; c.tail.erase (0, at + prompt.size())) {
+          if (! c.greeted) { c.greeted = true; continue; }
+          latencies.push_back (std::chrono::nanoseconds (now - c.in_flight.front()).count());
+          c.in_flight.pop_front();
+          if (++c.answered == commands) ++done;
+        }
+        if (c.tail.size() > prompt.size()) c.tail.erase (0, c.tail.size() - prompt.size());
+      }
+      if (! c.greeted) continue;
+      auto const now = clock_type::now();
+      while (c.in_flight.size() < pipeline && c.sent < commands)
+        c.out.append (command), c.in_flight.push_back (now), ++c.sent;
+      if (! c.out.empty()) {
+        auto const put = send (c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (put < 0 && errno != EAGAIN) { std::cerr << "Error: cannot send\n"; return 1; }
+        c.out.erase (0, std::max<ssize_t> (put, 0));
+      }
+      epoll_event e { c.out.empty() ? EPOLLIN : EPOLLIN | EPOLLOUT, { .ptr = &c } };
+      epoll_ctl (poller, EPOLL_CTL_MOD, c.fd, &e);
+    }
+  }
+
+  double const seconds = std::chrono::duration<double> (clock_type::now() - start).count();
+  auto percentile = [&] (double const p) {
+    auto const at = latencies.begin() + std::size_t (p * (latencies.size() - 1));
+    std::nth_element (latencies.begin(), at, latencies.end());
+    return *at / 1000.0;
+  };
+  std::cout << "{\"sessions\":" << sessions << ",\"commands\":" << latencies.size() << ",\"pipeline\":" << pipeline
+            << ",\"seconds\":" << seconds << ",\"commands_per_sec\":" << latencies.size() / seconds
+            << ",\"p50_us\":" << percentile (0.50) << ",\"p99_us\":" << percentile (0.99) << "}\n";
+  for (auto& c : clients) close (c.fd);
+  return 0;
+}